@@ -0,0 +1,113 @@
+// # Copyright (c) Dylan Leclair
+
+#include "Board.h"
+#include "Nnue.h"
+#include "Search.h"
+#include "ThreadedSearch.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+// a few quiet and tactical middlegames, the openings of the perft corpus
+static const std::vector<std::string> positions = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r1bqkb1r/pp3ppp/2n1pn2/2pp4/3P4/2PBPN2/PP3PPP/RNBQK2R w KQkq - 0 6",
+    "2r2rk1/pp1bqppp/2n1pn2/3p4/2PP4/P1NBPN2/1P3PPP/R2Q1RK1 b - - 2 12",
+};
+
+static void printUsage()
+{
+    std::cout << "usage: chess_bench [--threads N] [--depth N] [--hash MB] [--fen \"<fen>\"] [--nnue <network file>]" << std::endl
+              << std::endl
+              << "searches every position to the given depth with 1, 2, 4 ... N threads and reports" << std::endl
+              << "the time to depth of each thread count and its speedup over one thread." << std::endl
+              << "the hash table is cleared before every position. with --nnue the network evaluates." << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    int depth = 8;
+    size_t hashMb = 64;
+    std::vector<std::string> fens = positions;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--threads" && hasValue)
+            maxThreads = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--depth" && hasValue)
+            depth = std::atoi(argv[++i]);
+        else if (arg == "--hash" && hasValue)
+            hashMb = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--fen" && hasValue)
+            fens = {argv[++i]};
+        else if (arg == "--nnue" && hasValue)
+        {
+            if (!nnue::load(argv[++i]))
+                return 1;
+        }
+        else
+        {
+            printUsage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    std::vector<int> threadCounts;
+    for (int threads = 1; threads < maxThreads; threads *= 2)
+        threadCounts.push_back(threads);
+    threadCounts.push_back(maxThreads);
+
+    search::ThreadedSearch engine(hashMb);
+    search::Limits limits;
+    limits.m_depth = depth;
+
+    std::cout << fens.size() << " positions, depth " << depth << ", " << hashMb << " MB hash";
+    if (nnue::isLoaded())
+        std::cout << ", nnue (" << nnue::kernels().m_name << ")";
+    std::cout << std::endl
+              << std::endl;
+
+    double baseline = 0;
+    for (int threads : threadCounts)
+    {
+        engine.setThreads(threads);
+        uint64_t nodes = 0;
+        uint64_t pawnProbes = 0;
+        uint64_t pawnHits = 0;
+        double seconds = 0;
+        for (const std::string &fen : fens)
+        {
+            Board board(fen);
+            engine.table().clear();
+            Clock::time_point start = Clock::now();
+            search::Result result = engine.run(board, limits);
+            seconds += std::chrono::duration<double>(Clock::now() - start).count();
+            nodes += result.m_nodes;
+            pawnProbes += result.m_pawnProbes;
+            pawnHits += result.m_pawnHits;
+        }
+
+        if (threads == 1)
+            baseline = seconds;
+        std::cout << "threads " << threads << ": " << seconds << "s to depth, "
+                  << nodes << " nodes (" << static_cast<uint64_t>(nodes / (seconds > 0 ? seconds : 1)) << " nodes/sec), "
+                  << "speedup " << baseline / (seconds > 0 ? seconds : 1) << "x";
+        // none with a network loaded, it doesn't look at the pawns separately
+        if (pawnProbes)
+            std::cout << ", pawn hash hits " << 100.0 * pawnHits / pawnProbes << "%";
+        std::cout << std::endl;
+    }
+    return 0;
+}
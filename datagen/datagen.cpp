@@ -0,0 +1,177 @@
+// # Copyright (c) Dylan Leclair
+
+#include "Board.h"
+#include "Match.h"
+#include "Nnue.h"
+#include "Search.h"
+#include "ThreadedSearch.h"
+#include "TrainingData.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const char *START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+static void printUsage()
+{
+    std::cout << "usage: chess_datagen --out <file> [--games N] [--concurrency N] [--engine <config>]" << std::endl
+              << "                     [--random-plies N] [--seed S] [--nnue <network file>]" << std::endl
+              << "       chess_datagen --shuffle <in> <out> [--seed S]" << std::endl
+              << std::endl
+              << "plays self-play games from openings of random moves and appends their quiet positions to the file," << std::endl
+              << "32 bytes each, with the search's score and the game's result (see TrainingData.h)." << std::endl
+              << "the engine is configured as for chess_match (default \"nodes=5000\"). files are merged with cat," << std::endl
+              << "and --shuffle writes one out in a random order." << std::endl;
+}
+
+// a few random moves from the start, so the games don't all play the same; empty if they ended the game
+static std::string randomOpening(std::mt19937_64 &rng, int plies)
+{
+    Board board{std::string(START_FEN)};
+    for (int ply = 0; ply < plies; ply++)
+    {
+        MoveList moves;
+        board.getLegalMoves(moves);
+        if (moves.empty())
+            return "";
+        board.move(moves[rng() % moves.size()]);
+    }
+    MoveList moves;
+    board.getLegalMoves(moves);
+    return moves.empty() ? "" : board.getFen();
+}
+
+// the positions of a game worth learning from: the ones where the search's score is about the position as it
+// stands, not about a capture or mate it saw coming
+static void quietPositions(const match::GameRecord &game, std::vector<training::PackedPosition> &positions)
+{
+    const int result = game.m_outcome == match::Outcome::WhiteWins ? 1 : game.m_outcome == match::Outcome::BlackWins ? -1 : 0;
+    Board board(game.m_startFen);
+    for (size_t i = 0; i < game.m_moves.size(); i++)
+    {
+        const Move move = game.m_moves[i];
+        const int score = game.m_scores[i];
+        if (!board.isInCheck(board.getPlayerToMove()) && !move.isCapture() && !move.isPromotion() && std::abs(score) < search::MATE_BOUND)
+            positions.push_back(training::pack(board, score, result));
+        board.move(move);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::string outPath;
+    std::string shuffleFrom;
+    int games = 1000;
+    int concurrency = std::max(1u, std::thread::hardware_concurrency());
+    int randomPlies = 8;
+    uint64_t seed = 585;
+    match::EngineConfig engine;
+    match::parseEngine("name=datagen,nodes=5000", engine);
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--out" && hasValue)
+            outPath = argv[++i];
+        else if (arg == "--shuffle" && i + 2 < argc)
+        {
+            shuffleFrom = argv[++i];
+            outPath = argv[++i];
+        }
+        else if (arg == "--games" && hasValue)
+            games = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--concurrency" && hasValue)
+            concurrency = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--random-plies" && hasValue)
+            randomPlies = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--seed" && hasValue)
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--engine" && hasValue)
+        {
+            if (!match::parseEngine(argv[++i], engine))
+                return 1;
+        }
+        else if (arg == "--nnue" && hasValue)
+        {
+            if (!nnue::load(argv[++i]))
+                return 1;
+        }
+        else
+        {
+            printUsage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+    if (outPath.empty())
+    {
+        printUsage();
+        return 1;
+    }
+
+    if (!shuffleFrom.empty())
+        return training::shuffle(shuffleFrom, outPath, seed) ? 0 : 1;
+
+    training::Writer writer;
+    if (!writer.open(outPath))
+        return 1;
+    std::cout << "datagen: " << games << " games of " << engine.m_name << " against itself, " << concurrency
+              << " at a time, appending to " << outPath << std::endl;
+
+    std::atomic<int> nextGame{0};
+    std::mutex mutex;
+    int played = 0;
+    uint64_t written = 0;
+    const auto start = std::chrono::steady_clock::now();
+    auto lastReport = start;
+    auto seconds = [](std::chrono::steady_clock::time_point from) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - from).count();
+    };
+
+    auto work = [&]() {
+        search::ThreadedSearch search(engine.m_hashMb);
+        std::vector<training::PackedPosition> positions;
+        for (int game; (game = nextGame++) < games;)
+        {
+            // seeded by the game, so a run can be repeated whatever the concurrency
+            std::mt19937_64 rng(seed * 1000003 + game);
+            std::string opening;
+            while (opening.empty())
+                opening = randomOpening(rng, randomPlies);
+
+            match::GameRecord record = match::playGame(opening, engine, engine, search, search, match::Adjudication());
+            positions.clear();
+            quietPositions(record, positions);
+            writer.write(positions.data(), positions.size());
+
+            std::lock_guard<std::mutex> lock(mutex);
+            played++;
+            written += positions.size();
+            if (seconds(lastReport) >= 10 || played == games)
+            {
+                lastReport = std::chrono::steady_clock::now();
+                char line[160];
+                std::snprintf(line, sizeof(line), "%d games, %llu positions, %.0f positions/sec", played,
+                              static_cast<unsigned long long>(written), written / std::max(seconds(start), 1e-9));
+                std::cout << line << std::endl;
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int i = 1; i < concurrency; i++)
+        workers.emplace_back(work);
+    work();
+    for (std::thread &worker : workers)
+        worker.join();
+    return 0;
+}
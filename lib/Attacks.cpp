@@ -0,0 +1,129 @@
+// # Copyright (c) Dylan Leclair
+#include "Attacks.h"
+
+#include <vector>
+
+namespace attacks
+{
+    Magic rookMagics[64];
+    Magic bishopMagics[64];
+
+    // sum over all squares of 2^(relevant bits): 102400 for rooks, 5248 for bishops
+    static Bitboard rookTable[0x19000];
+    static Bitboard bishopTable[0x1480];
+
+    static const int rookDirections[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+    static const int bishopDirections[4][2] = {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+
+    Bitboard slidingAttacks(bool rook, int square, Bitboard occupied)
+    {
+        const int(*directions)[2] = rook ? rookDirections : bishopDirections;
+        Bitboard result = 0;
+        for (int d = 0; d < 4; d++)
+        {
+            int row = ROW_OF(square) + directions[d][0];
+            int col = COL_OF(square) + directions[d][1];
+            while (0 <= row && row < 8 && 0 <= col && col < 8)
+            {
+                result |= SQUARE_BB(SQUARE(row, col));
+                if (occupied & SQUARE_BB(SQUARE(row, col)))
+                    break;
+                row += directions[d][0];
+                col += directions[d][1];
+            }
+        }
+        return result;
+    }
+
+#if !defined(USE_PEXT)
+    // xorshift64*, seeded with a constant so the magics found are the same on every run
+    static uint64_t nextRandom(uint64_t &state)
+    {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 2685821657736338717ULL;
+    }
+
+    // tries sparse random numbers until one maps every blocker subset without a destructive collision
+    static void findMagic(Magic &m, const std::vector<Bitboard> &occupancies, const std::vector<Bitboard> &references, int size)
+    {
+        static std::vector<int> epoch(4096, 0);
+        static int attempt = 0;
+        static uint64_t seed = 0x9E3779B97F4A7C15ULL;
+
+        for (int i = 0; i < size;)
+        {
+            do
+            {
+                m.m_magic = nextRandom(seed) & nextRandom(seed) & nextRandom(seed);
+            } while (bitboard::popCount((m.m_mask * m.m_magic) >> 56) < 6);
+
+            attempt++;
+            for (i = 0; i < size; i++)
+            {
+                unsigned index = m.index(occupancies[i]);
+                if (epoch[index] < attempt)
+                {
+                    epoch[index] = attempt;
+                    m.m_attacks[index] = references[i];
+                }
+                else if (m.m_attacks[index] != references[i])
+                {
+                    break;
+                }
+            }
+        }
+    }
+#endif
+
+    static void initMagics(bool rook, Magic magics[64], Bitboard *table)
+    {
+        const Bitboard rowEdges = 0xFF000000000000FFULL;  // rows 0 and 7
+        const Bitboard colEdges = 0x8181818181818181ULL;  // cols 0 and 7
+
+        std::vector<Bitboard> occupancies(4096);
+        std::vector<Bitboard> references(4096);
+
+        for (int square = 0; square < 64; square++)
+        {
+            // the edge squares never change the attack set (unless the piece sits on that edge)
+            Bitboard edges = (rowEdges & ~(0xFFULL << (ROW_OF(square) * 8))) |
+                             (colEdges & ~(0x0101010101010101ULL << COL_OF(square)));
+
+            Magic &m = magics[square];
+            m.m_magic = 0;
+            m.m_mask = slidingAttacks(rook, square, 0) & ~edges;
+            m.m_shift = 64 - bitboard::popCount(m.m_mask);
+            m.m_attacks = (square == 0) ? table : magics[square - 1].m_attacks + (1u << (64 - magics[square - 1].m_shift));
+
+            // enumerate every subset of the mask (carry-rippler)
+            int size = 0;
+            Bitboard subset = 0;
+            do
+            {
+                occupancies[size] = subset;
+                references[size] = slidingAttacks(rook, square, subset);
+#if defined(USE_PEXT)
+                m.m_attacks[_pext_u64(subset, m.m_mask)] = references[size];
+#endif
+                size++;
+                subset = (subset - m.m_mask) & m.m_mask;
+            } while (subset);
+
+#if !defined(USE_PEXT)
+            findMagic(m, occupancies, references, size);
+#endif
+        }
+    }
+
+    // builds the slider tables before main(). nothing in this project uses a Board during static init.
+    static struct Initializer
+    {
+        Initializer()
+        {
+            initMagics(true, rookMagics, rookTable);
+            initMagics(false, bishopMagics, bishopTable);
+        }
+    } initializer;
+}
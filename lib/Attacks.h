@@ -0,0 +1,165 @@
+// # Copyright (c) Dylan Leclair
+#pragma once
+
+#include "Bitboard.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(USE_PEXT)
+#include <immintrin.h>
+#endif
+
+// precomputed attack sets. knights, kings and pawns are a plain lookup by square, in tables built at compile time.
+// for sliding pieces the relevant blockers of a square are hashed to an index into a shared attack table, either by a
+// magic multiplication or (when the build machine has BMI2, see lib/CMakeLists.txt) by PEXT,
+// so a rook/bishop/queen attack set is one table lookup no matter how crowded the rays are.
+namespace attacks
+{
+    struct Magic
+    {
+        Bitboard m_mask;  // relevant blocker squares (rays without the board edge)
+        Bitboard m_magic; // unused when indexing with PEXT
+        Bitboard *m_attacks;
+        unsigned m_shift;
+
+        unsigned index(Bitboard occupied) const
+        {
+#if defined(USE_PEXT)
+            return static_cast<unsigned>(_pext_u64(occupied, m_mask));
+#else
+            return static_cast<unsigned>(((occupied & m_mask) * m_magic) >> m_shift);
+#endif
+        }
+    };
+
+    extern Magic rookMagics[64];
+    extern Magic bishopMagics[64];
+
+    namespace detail
+    {
+        constexpr int knightOffsets[8][2] = {{2, 1}, {2, -1}, {-2, 1}, {-2, -1}, {1, 2}, {1, -2}, {-1, 2}, {-1, -2}};
+        constexpr int kingOffsets[8][2] = {{0, 1}, {0, -1}, {1, 0}, {-1, 0}, {1, 1}, {-1, 1}, {1, -1}, {-1, -1}};
+        // white pawns move towards row 0, black pawns towards row 7
+        constexpr int whitePawnOffsets[2][2] = {{-1, -1}, {-1, 1}};
+        constexpr int blackPawnOffsets[2][2] = {{1, -1}, {1, 1}};
+        constexpr int whitePushOffset[1][2] = {{-1, 0}};
+        constexpr int blackPushOffset[1][2] = {{1, 0}};
+
+        constexpr int sign(int x) { return (x > 0) - (x < 0); }
+        constexpr int absolute(int x) { return x < 0 ? -x : x; }
+        constexpr bool onBoard(int row, int col) { return 0 <= row && row < 8 && 0 <= col && col < 8; }
+
+        template <size_t N>
+        constexpr std::array<Bitboard, 64> leaperTable(const int (&offsets)[N][2])
+        {
+            std::array<Bitboard, 64> table{};
+            for (int square = 0; square < 64; square++)
+            {
+                for (size_t i = 0; i < N; i++)
+                {
+                    int row = ROW_OF(square) + offsets[i][0];
+                    int col = COL_OF(square) + offsets[i][1];
+                    if (onBoard(row, col))
+                        table[square] |= SQUARE_BB(SQUARE(row, col));
+                }
+            }
+            return table;
+        }
+
+        // whether the squares share a row, column or diagonal
+        constexpr bool aligned(int a, int b)
+        {
+            int rows = ROW_OF(b) - ROW_OF(a);
+            int cols = COL_OF(b) - COL_OF(a);
+            return a != b && (rows == 0 || cols == 0 || absolute(rows) == absolute(cols));
+        }
+
+        // from a towards b, one square at a time: everything up to b, or (through) up to the edge of the board
+        constexpr Bitboard walk(int a, int b, bool through)
+        {
+            const int rowStep = sign(ROW_OF(b) - ROW_OF(a));
+            const int colStep = sign(COL_OF(b) - COL_OF(a));
+            Bitboard result = 0;
+            for (int row = ROW_OF(a) + rowStep, col = COL_OF(a) + colStep; onBoard(row, col); row += rowStep, col += colStep)
+            {
+                if (!through && SQUARE(row, col) == b)
+                    break;
+                result |= SQUARE_BB(SQUARE(row, col));
+            }
+            return result;
+        }
+
+        constexpr std::array<std::array<Bitboard, 64>, 64> betweenTable()
+        {
+            std::array<std::array<Bitboard, 64>, 64> table{};
+            for (int a = 0; a < 64; a++)
+                for (int b = 0; b < 64; b++)
+                    table[a][b] = aligned(a, b) ? walk(a, b, false) : 0;
+            return table;
+        }
+
+        constexpr std::array<std::array<Bitboard, 64>, 64> lineTable()
+        {
+            std::array<std::array<Bitboard, 64>, 64> table{};
+            for (int a = 0; a < 64; a++)
+                for (int b = 0; b < 64; b++)
+                    table[a][b] = aligned(a, b) ? walk(a, b, true) | walk(b, a, true) : 0;
+            return table;
+        }
+
+        constexpr std::array<std::array<uint8_t, 64>, 64> distanceTable()
+        {
+            std::array<std::array<uint8_t, 64>, 64> table{};
+            for (int a = 0; a < 64; a++)
+            {
+                for (int b = 0; b < 64; b++)
+                {
+                    int rows = absolute(ROW_OF(b) - ROW_OF(a));
+                    int cols = absolute(COL_OF(b) - COL_OF(a));
+                    table[a][b] = static_cast<uint8_t>(rows > cols ? rows : cols);
+                }
+            }
+            return table;
+        }
+    }
+
+    // the tables that don't depend on blockers are worked out by the compiler: read only data, nothing to set up
+    // when the program starts and no bounds checks when they're used
+    inline constexpr std::array<Bitboard, 64> knightAttacks = detail::leaperTable(detail::knightOffsets);
+    inline constexpr std::array<Bitboard, 64> kingAttacks = detail::leaperTable(detail::kingOffsets);
+    // indexed by the colour of the attacking pawn
+    inline constexpr std::array<std::array<Bitboard, 64>, 2> pawnAttacks = {detail::leaperTable(detail::whitePawnOffsets),
+                                                                             detail::leaperTable(detail::blackPawnOffsets)};
+    // the square in front of a pawn (0 on the last row)
+    inline constexpr std::array<std::array<Bitboard, 64>, 2> pawnPushes = {detail::leaperTable(detail::whitePushOffset),
+                                                                            detail::leaperTable(detail::blackPushOffset)};
+
+    // squares strictly between two squares on a shared row, column or diagonal (0 if not aligned)
+    inline constexpr std::array<std::array<Bitboard, 64>, 64> between = detail::betweenTable();
+    // the whole row, column or diagonal through two squares, edge to edge (0 if not aligned)
+    inline constexpr std::array<std::array<Bitboard, 64>, 64> line = detail::lineTable();
+    // king moves from one square to the other on an empty board (the larger of the row and column distance)
+    inline constexpr std::array<std::array<uint8_t, 64>, 64> distance = detail::distanceTable();
+
+    inline Bitboard rookAttacks(int square, Bitboard occupied)
+    {
+        const Magic &m = rookMagics[square];
+        return m.m_attacks[m.index(occupied)];
+    }
+
+    inline Bitboard bishopAttacks(int square, Bitboard occupied)
+    {
+        const Magic &m = bishopMagics[square];
+        return m.m_attacks[m.index(occupied)];
+    }
+
+    inline Bitboard queenAttacks(int square, Bitboard occupied)
+    {
+        return rookAttacks(square, occupied) | bishopAttacks(square, occupied);
+    }
+
+    /// @brief walks the rays square by square. only used to build (and test) the tables.
+    Bitboard slidingAttacks(bool rook, int square, Bitboard occupied);
+}
@@ -0,0 +1,440 @@
+// # Copyright (c) Dylan Leclair
+#include "Batch.h"
+#include "Attacks.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define BATCH_X86
+#endif
+
+// the kernel is compiled once per instruction set by inlining it into each entry point,
+// which the compiler only does for a function that big when made to
+#if defined(__GNUC__) || defined(__clang__)
+#define KERNEL_INLINE inline __attribute__((always_inline))
+#else
+#define KERNEL_INLINE inline
+#endif
+
+namespace batch
+{
+    namespace
+    {
+        const Bitboard FILE_A = 0x0101010101010101ULL;
+        const Bitboard FILE_B = FILE_A << 1;
+        const Bitboard FILE_G = FILE_A << 6;
+        const Bitboard FILE_H = FILE_A << 7;
+        const Bitboard ALL = ~static_cast<Bitboard>(0);
+
+        // the set-wise versions of the attack tables: every square of a bitboard moved at once, so the same
+        // instructions work for any position. a positive shift goes down the board (towards white's side),
+        // and the wrap mask drops whatever went off one side of the board and came back on the other
+        template <int S>
+        KERNEL_INLINE Bitboard shift(Bitboard b)
+        {
+            return S > 0 ? b << S : b >> -S;
+        }
+
+        template <int S, Bitboard Wrap>
+        KERNEL_INLINE Bitboard step(Bitboard b)
+        {
+            return shift<S>(b) & Wrap;
+        }
+
+        // the squares reached from gen going along the direction through empty squares (gen included),
+        // doubling the distance each round (Kogge-Stone)
+        template <int S, Bitboard Wrap>
+        KERNEL_INLINE Bitboard fill(Bitboard gen, Bitboard empty)
+        {
+            empty &= Wrap;
+            gen |= empty & shift<S>(gen);
+            empty &= shift<S>(empty);
+            gen |= empty & shift<2 * S>(gen);
+            empty &= shift<2 * S>(empty);
+            gen |= empty & shift<4 * S>(gen);
+            return gen;
+        }
+
+        KERNEL_INLINE Bitboard whitePawnAttacks(Bitboard b) { return step<-7, ~FILE_A>(b) | step<-9, ~FILE_H>(b); }
+        KERNEL_INLINE Bitboard blackPawnAttacks(Bitboard b) { return step<9, ~FILE_A>(b) | step<7, ~FILE_H>(b); }
+
+        KERNEL_INLINE Bitboard knightAttacks(Bitboard b)
+        {
+            const Bitboard one = step<1, ~FILE_A>(b) | step<-1, ~FILE_H>(b);
+            const Bitboard two = step<2, ~(FILE_A | FILE_B)>(b) | step<-2, ~(FILE_G | FILE_H)>(b);
+            return shift<16>(one) | shift<-16>(one) | shift<8>(two) | shift<-8>(two);
+        }
+
+        KERNEL_INLINE Bitboard kingAttacks(Bitboard b)
+        {
+            const Bitboard row = b | step<1, ~FILE_A>(b) | step<-1, ~FILE_H>(b);
+            return (row | shift<8>(row) | shift<-8>(row)) ^ b;
+        }
+
+        // all ones if anything is set, without a branch
+        KERNEL_INLINE Bitboard whenSet(Bitboard b) { return 0 - static_cast<Bitboard>(b != 0); }
+
+        // what one position's kernel works out
+        struct Lane
+        {
+            Bitboard m_danger{0};
+            Bitboard m_checkers{0};
+            Bitboard m_blockers{0}; // the squares between the king and a checking slider
+            Bitboard m_pinned{0};
+        };
+
+        // one direction: how far their sliders along it see (through our king), and looking from our king the
+        // other way round, a slider checking it or one of our pieces pinned against it
+        template <int S, Bitboard Wrap>
+        KERNEL_INLINE void slide(Lane &lane, Bitboard sliders, Bitboard king, Bitboard us, Bitboard occupied)
+        {
+            const Bitboard empty = ~occupied;
+            lane.m_danger |= step<S, Wrap>(fill<S, Wrap>(sliders, empty | king));
+
+            const Bitboard ray = fill<S, Wrap>(king, empty);
+            const Bitboard first = step<S, Wrap>(ray) & occupied;
+            const Bitboard checker = first & sliders;
+            lane.m_checkers |= checker;
+            lane.m_blockers |= (ray ^ king) & whenSet(checker);
+            const Bitboard shield = first & us;
+            lane.m_pinned |= shield & whenSet(step<S, Wrap>(fill<S, Wrap>(shield, empty)) & sliders);
+        }
+
+        // the danger, check masks and pins of every position: straight line code on each position's
+        // bitboards, so the loop is vectorised across positions
+        KERNEL_INLINE void analyse(const Positions &positions, Bitboard *__restrict danger, Bitboard *__restrict checkMask, Bitboard *__restrict pinned)
+        {
+            const Bitboard *pieces[12];
+            for (int piece = 0; piece < 12; piece++)
+                pieces[piece] = positions.m_pieces[piece].data();
+            const uint8_t *sideToMove = positions.m_sideToMove.data();
+            const size_t size = positions.size();
+
+            // all ones with black to move, to pick between the colours without a branch. widened in a loop of its
+            // own (into the first output, which nothing reads before it's written): mixing byte and 64 bit
+            // lanes in the main loop stops it being vectorised
+            for (size_t i = 0; i < size; i++)
+                danger[i] = 0 - static_cast<Bitboard>(sideToMove[i]);
+
+            for (size_t i = 0; i < size; i++)
+            {
+                const Bitboard black = danger[i];
+                Bitboard position[12];
+                for (int piece = 0; piece < 12; piece++)
+                    position[piece] = pieces[piece][i];
+                auto ours = [&](Piece piece) { return (position[piece - 1] & ~black) | (position[piece + 5] & black); };
+                auto theirs = [&](Piece piece) { return (position[piece + 5] & ~black) | (position[piece - 1] & black); };
+
+                const Bitboard king = ours(Piece::WHITE_KING);
+                const Bitboard us = ours(Piece::WHITE_PAWN) | ours(Piece::WHITE_ROOK) | ours(Piece::WHITE_KNIGHT) |
+                                    ours(Piece::WHITE_BISHOP) | ours(Piece::WHITE_QUEEN) | king;
+                const Bitboard pawns = theirs(Piece::WHITE_PAWN);
+                const Bitboard knights = theirs(Piece::WHITE_KNIGHT);
+                const Bitboard rooks = theirs(Piece::WHITE_ROOK) | theirs(Piece::WHITE_QUEEN);
+                const Bitboard bishops = theirs(Piece::WHITE_BISHOP) | theirs(Piece::WHITE_QUEEN);
+                const Bitboard them = pawns | knights | rooks | bishops | theirs(Piece::WHITE_KING);
+                const Bitboard occupied = us | them;
+
+                Lane lane;
+                lane.m_danger = (blackPawnAttacks(pawns) & ~black) | (whitePawnAttacks(pawns) & black) |
+                                knightAttacks(knights) | kingAttacks(theirs(Piece::WHITE_KING));
+                lane.m_checkers = (((whitePawnAttacks(king) & ~black) | (blackPawnAttacks(king) & black)) & pawns) |
+                                  (knightAttacks(king) & knights);
+                slide<-8, ALL>(lane, rooks, king, us, occupied);
+                slide<8, ALL>(lane, rooks, king, us, occupied);
+                slide<1, ~FILE_A>(lane, rooks, king, us, occupied);
+                slide<-1, ~FILE_H>(lane, rooks, king, us, occupied);
+                slide<-7, ~FILE_A>(lane, bishops, king, us, occupied);
+                slide<-9, ~FILE_H>(lane, bishops, king, us, occupied);
+                slide<9, ~FILE_A>(lane, bishops, king, us, occupied);
+                slide<7, ~FILE_H>(lane, bishops, king, us, occupied);
+
+                // everything when not in check, nothing in double check
+                const Bitboard noCheck = 0 - static_cast<Bitboard>(lane.m_checkers == 0);
+                const Bitboard doubleCheck = whenSet(lane.m_checkers & (lane.m_checkers - 1));
+                danger[i] = lane.m_danger;
+                checkMask[i] = noCheck | ((lane.m_checkers | lane.m_blockers) & ~doubleCheck);
+                pinned[i] = lane.m_pinned;
+            }
+        }
+
+        using Kernel = void (*)(const Positions &, Bitboard *, Bitboard *, Bitboard *);
+
+        void analyseDefault(const Positions &positions, Bitboard *danger, Bitboard *checkMask, Bitboard *pinned)
+        {
+            analyse(positions, danger, checkMask, pinned);
+        }
+
+#ifdef BATCH_X86
+        // the same loop compiled for four positions a vector, only called once the CPU is known to have AVX2
+        __attribute__((target("avx2"))) void analyseAvx2(const Positions &positions, Bitboard *danger, Bitboard *checkMask, Bitboard *pinned)
+        {
+            analyse(positions, danger, checkMask, pinned);
+        }
+#endif
+
+        struct Dispatch
+        {
+            const char *m_name;
+            Kernel m_kernel;
+        };
+
+        Dispatch bestKernel()
+        {
+#ifdef BATCH_X86
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2"))
+                return {"avx2", analyseAvx2};
+#endif
+            return {"default", analyseDefault};
+        }
+
+        const Dispatch dispatch = bestKernel();
+
+        // the moves of one position, from what analyse worked out
+        class Writer
+        {
+        public:
+            Writer(const Positions &positions, size_t index, Move *moves)
+                : m_moves(moves), m_us(static_cast<PlayerColor>(positions.m_sideToMove[index]))
+            {
+                for (int piece = 0; piece < 12; piece++)
+                {
+                    Bitboard bb = positions.m_pieces[piece][index];
+                    if (getPieceColor(static_cast<Piece>(piece + 1)) == m_us)
+                        m_ours |= bb;
+                    else
+                        m_theirs |= bb;
+                }
+            }
+
+            int size() const { return m_size; }
+            PlayerColor us() const { return m_us; }
+            Bitboard occupied() const { return m_ours | m_theirs; }
+
+            void add(int from, Bitboard targets)
+            {
+                targets &= ~m_ours;
+                while (targets)
+                {
+                    int to = bitboard::popLsb(targets);
+                    m_moves[m_size++] = Move(from, to, (m_theirs & SQUARE_BB(to)) ? Move::CAPTURE : Move::QUIET);
+                }
+            }
+
+            // the pawns' moves to the squares allowed, all the pawns at once
+            void addPawns(Bitboard pawns, Bitboard allowed)
+            {
+                const Bitboard empty = ~(m_ours | m_theirs);
+                const bool white = m_us == PlayerColor::White;
+                // one row up the board for white, down for black, and the row the pawns land on after one step
+                const int forward = white ? -8 : 8;
+                const Bitboard thirdRow = white ? 0xFFULL << 40 : 0xFFULL << 16;
+
+                Bitboard single = (white ? pawns >> 8 : pawns << 8) & empty;
+                Bitboard twice = (white ? (single & thirdRow) >> 8 : (single & thirdRow) << 8) & empty & allowed;
+                addPawnTargets(single & allowed, forward, 0);
+                while (twice)
+                {
+                    int to = bitboard::popLsb(twice);
+                    m_moves[m_size++] = Move(to - 2 * forward, to, Move::DOUBLE_PUSH);
+                }
+                addPawnTargets((white ? step<-7, ~FILE_A>(pawns) : step<9, ~FILE_A>(pawns)) & m_theirs & allowed,
+                               white ? -7 : 9, Move::CAPTURE);
+                addPawnTargets((white ? step<-9, ~FILE_H>(pawns) : step<7, ~FILE_H>(pawns)) & m_theirs & allowed,
+                               white ? -9 : 7, Move::CAPTURE);
+            }
+
+            void addMove(int from, int to, uint8_t flags) { m_moves[m_size++] = Move(from, to, flags); }
+
+        private:
+            void addPawnTargets(Bitboard targets, int offset, uint8_t capture)
+            {
+                const Bitboard lastRows = 0xFFULL | 0xFFULL << 56;
+                while (targets)
+                {
+                    int to = bitboard::popLsb(targets);
+                    if (lastRows & SQUARE_BB(to))
+                    {
+                        for (uint8_t promotion : {Move::QUEEN_PROMOTION, Move::ROOK_PROMOTION, Move::BISHOP_PROMOTION, Move::KNIGHT_PROMOTION})
+                            m_moves[m_size++] = Move(to - offset, to, promotion | capture);
+                    }
+                    else
+                    {
+                        m_moves[m_size++] = Move(to - offset, to, capture);
+                    }
+                }
+            }
+
+            Move *m_moves;
+            int m_size{0};
+            PlayerColor m_us;
+            Bitboard m_ours{0};
+            Bitboard m_theirs{0};
+        };
+
+        int writeMoves(const Positions &positions, size_t index, Bitboard danger, Bitboard checkMask, Bitboard pinned, Move *out)
+        {
+            Writer writer(positions, index, out);
+            const PlayerColor us = writer.us();
+            auto ours = [&](Piece piece) { return positions.m_pieces[us == PlayerColor::White ? piece - 1 : piece + 5][index]; };
+            auto theirs = [&](Piece piece) { return positions.m_pieces[us == PlayerColor::White ? piece + 5 : piece - 1][index]; };
+
+            const Bitboard kings = ours(Piece::WHITE_KING);
+            if (!kings)
+            {
+                // nothing to keep safe: every move goes
+                checkMask = ALL;
+                pinned = 0;
+            }
+            const int king = kings ? bitboard::lsb(kings) : -1;
+            const Bitboard occupied = writer.occupied();
+
+            if (kings)
+            {
+                writer.add(king, attacks::kingAttacks[king] & ~danger);
+
+                // the king and both squares it crosses have to be safe, the squares up to the rook empty
+                const int row = us == PlayerColor::White ? 7 : 0;
+                const uint8_t rights = positions.m_castling[index] >> (us == PlayerColor::White ? 0 : 2);
+                const Bitboard rooks = ours(Piece::WHITE_ROOK);
+                if (king == SQUARE(row, 4) && !(danger & kings))
+                {
+                    if ((rights & CastlingRights::WHITE_KINGSIDE) && (rooks & SQUARE_BB(SQUARE(row, 7))) &&
+                        !(occupied & (SQUARE_BB(SQUARE(row, 5)) | SQUARE_BB(SQUARE(row, 6)))) &&
+                        !(danger & (SQUARE_BB(SQUARE(row, 5)) | SQUARE_BB(SQUARE(row, 6)))))
+                        writer.addMove(king, SQUARE(row, 6), Move::KINGSIDE_CASTLE);
+                    if ((rights & CastlingRights::WHITE_QUEENSIDE) && (rooks & SQUARE_BB(SQUARE(row, 0))) &&
+                        !(occupied & (SQUARE_BB(SQUARE(row, 1)) | SQUARE_BB(SQUARE(row, 2)) | SQUARE_BB(SQUARE(row, 3)))) &&
+                        !(danger & (SQUARE_BB(SQUARE(row, 2)) | SQUARE_BB(SQUARE(row, 3)))))
+                        writer.addMove(king, SQUARE(row, 2), Move::QUEENSIDE_CASTLE);
+                }
+            }
+            // double check: only the king moves
+            if (!checkMask)
+                return writer.size();
+
+            // a pinned piece stays on the line through its king
+            auto allowed = [&](int from) { return (pinned & SQUARE_BB(from)) ? checkMask & attacks::line[king][from] : checkMask; };
+
+            // a pinned knight can never move
+            Bitboard knights = ours(Piece::WHITE_KNIGHT) & ~pinned;
+            while (knights)
+            {
+                int from = bitboard::popLsb(knights);
+                writer.add(from, attacks::knightAttacks[from] & checkMask);
+            }
+            const Bitboard queens = ours(Piece::WHITE_QUEEN);
+            Bitboard rooks = ours(Piece::WHITE_ROOK) | queens;
+            while (rooks)
+            {
+                int from = bitboard::popLsb(rooks);
+                writer.add(from, attacks::rookAttacks(from, occupied) & allowed(from));
+            }
+            Bitboard bishops = ours(Piece::WHITE_BISHOP) | queens;
+            while (bishops)
+            {
+                int from = bitboard::popLsb(bishops);
+                writer.add(from, attacks::bishopAttacks(from, occupied) & allowed(from));
+            }
+
+            const Bitboard pawns = ours(Piece::WHITE_PAWN);
+            writer.addPawns(pawns & ~pinned, checkMask);
+            Bitboard pinnedPawns = pawns & pinned;
+            while (pinnedPawns)
+            {
+                int from = bitboard::popLsb(pinnedPawns);
+                writer.addPawns(SQUARE_BB(from), allowed(from));
+            }
+
+            const int enPassant = positions.m_enPassant[index];
+            if (enPassant >= 0)
+            {
+                const PlayerColor them = us == PlayerColor::White ? PlayerColor::Black : PlayerColor::White;
+                const Bitboard target = SQUARE_BB(enPassant);
+                const int taken = enPassant + (us == PlayerColor::White ? 8 : -8);
+                Bitboard takers = attacks::pawnAttacks[them][enPassant] & pawns;
+                while (takers)
+                {
+                    // two pieces leave the row at once, so look at the king directly instead of with the masks:
+                    // the sliders with the board as it would be, and whatever else checks it unless it's the pawn taken
+                    int from = bitboard::popLsb(takers);
+                    if (kings)
+                    {
+                        const Bitboard after = (occupied ^ SQUARE_BB(from) ^ SQUARE_BB(taken)) | target;
+                        const Bitboard theirQueens = theirs(Piece::WHITE_QUEEN);
+                        const Bitboard leapers = (attacks::knightAttacks[king] & theirs(Piece::WHITE_KNIGHT)) |
+                                                 (attacks::pawnAttacks[us][king] & theirs(Piece::WHITE_PAWN) & ~SQUARE_BB(taken));
+                        if (leapers ||
+                            (attacks::rookAttacks(king, after) & (theirs(Piece::WHITE_ROOK) | theirQueens)) ||
+                            (attacks::bishopAttacks(king, after) & (theirs(Piece::WHITE_BISHOP) | theirQueens)))
+                            continue;
+                    }
+                    writer.addMove(from, enPassant, Move::EN_PASSANT);
+                }
+            }
+            return writer.size();
+        }
+    }
+
+    void Positions::resize(size_t size)
+    {
+        for (std::vector<Bitboard> &pieces : m_pieces)
+            pieces.resize(size);
+        m_sideToMove.resize(size);
+        m_castling.resize(size);
+        m_enPassant.resize(size, -1);
+    }
+
+    void Positions::set(size_t index, const Board &board)
+    {
+        const Bitboards &bitboards = board.getBitboards();
+        for (int piece = 0; piece < 12; piece++)
+            m_pieces[piece][index] = bitboards.m_pieces[piece];
+        m_sideToMove[index] = board.getPlayerToMove();
+        m_castling[index] = board.getCastlingRights();
+        m_enPassant[index] = static_cast<int8_t>(board.getEnPassantSquare());
+    }
+
+    void Positions::set(size_t index, const training::PackedPosition &position)
+    {
+        for (std::vector<Bitboard> &pieces : m_pieces)
+            pieces[index] = 0;
+        Bitboard occupied = position.m_occupancy;
+        for (int i = 0; occupied; i++)
+        {
+            int square = bitboard::popLsb(occupied);
+            int piece = (position.m_pieces[i / 2] >> (i % 2 * 4)) & 15;
+            if (piece >= Piece::WHITE_PAWN && piece <= Piece::BLACK_KING)
+                m_pieces[piece - 1][index] |= SQUARE_BB(square);
+        }
+        m_sideToMove[index] = position.sideToMove();
+        m_castling[index] = position.castling();
+        m_enPassant[index] = position.m_enPassant;
+    }
+
+    void MoveLists::resize(size_t size)
+    {
+        // vectors keep their capacity when they shrink, so only a bigger batch than any before allocates
+        m_moves.resize(size * MoveList::CAPACITY);
+        m_sizes.resize(size);
+        m_danger.resize(size);
+        m_checkMask.resize(size);
+        m_pinned.resize(size);
+    }
+
+    void generateLegalMoves(const Positions &positions, MoveLists &moves)
+    {
+        const size_t size = positions.size();
+        moves.resize(size);
+        dispatch.m_kernel(positions, moves.m_danger.data(), moves.m_checkMask.data(), moves.m_pinned.data());
+        for (size_t i = 0; i < size; i++)
+        {
+            moves.m_sizes[i] = static_cast<uint16_t>(writeMoves(positions, i, moves.m_danger[i], moves.m_checkMask[i],
+                                                                moves.m_pinned[i], moves.m_moves.data() + i * MoveList::CAPACITY));
+        }
+    }
+
+    const char *kernelName()
+    {
+        return dispatch.m_name;
+    }
+}
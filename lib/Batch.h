@@ -0,0 +1,66 @@
+// # Copyright (c) Dylan Leclair
+#pragma once
+
+#include "Bitboard.h"
+#include "Board.h"
+#include "Move.h"
+#include "TrainingData.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+/// @brief legal moves for many independent positions at once, without a Board per position.
+/// the positions are stored field by field (a structure of arrays), so the work that doesn't depend on where the
+/// pieces are (attack maps, checks and pins) runs as one loop of shifts and masks across positions, which the
+/// compiler vectorises. only writing out the moves is done a position at a time.
+namespace batch
+{
+    /// @brief a batch of positions: for each field, one entry per position.
+    /// positions should have at most one king a side, as any position from a game does.
+    struct Positions
+    {
+        // indexed by Piece - 1, like Bitboards::m_pieces
+        std::array<std::vector<Bitboard>, 12> m_pieces;
+        std::vector<uint8_t> m_sideToMove; // a PlayerColor
+        std::vector<uint8_t> m_castling;   // CastlingRights
+        std::vector<int8_t> m_enPassant;   // square, or -1
+
+        size_t size() const { return m_sideToMove.size(); }
+        // the new positions are empty, with white to move
+        void resize(size_t size);
+        void set(size_t index, const Board &board);
+        // straight from a record, without setting up a Board
+        void set(size_t index, const training::PackedPosition &position);
+    };
+
+    /// @brief the moves of each position in a batch. kept between batches: a batch no bigger than the last one
+    /// allocates nothing.
+    class MoveLists
+    {
+    public:
+        size_t size() const { return m_sizes.size(); }
+        const Move *begin(size_t index) const { return m_moves.data() + index * MoveList::CAPACITY; }
+        const Move *end(size_t index) const { return begin(index) + m_sizes[index]; }
+        int count(size_t index) const { return m_sizes[index]; }
+
+    private:
+        friend void generateLegalMoves(const Positions &positions, MoveLists &moves);
+        void resize(size_t size);
+
+        // MoveList::CAPACITY moves a position, so every list starts at a fixed place
+        std::vector<Move> m_moves;
+        std::vector<uint16_t> m_sizes;
+        // worked out for every position before any moves are written: the squares the side not to move attacks
+        // (seen through our king), the squares that stop a check (0 in double check) and our pinned pieces
+        std::vector<Bitboard> m_danger;
+        std::vector<Bitboard> m_checkMask;
+        std::vector<Bitboard> m_pinned;
+    };
+
+    /// @brief the same moves as Board::getLegalMoves, for every position in the batch (in a different order)
+    void generateLegalMoves(const Positions &positions, MoveLists &moves);
+
+    /// @brief the instruction set the batch kernels run with on this CPU, e.g. "avx2"
+    const char *kernelName();
+}
@@ -0,0 +1,93 @@
+// # Copyright (c) Dylan Leclair
+#pragma once
+
+#include "Piece.h"
+#include "PlayerColor.h"
+
+#include <array>
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// squares are numbered in the same layout as the old 8x8 grid:
+// square 0 is {row 0, col 0} (a8, black's back rank) and square 63 is {row 7, col 7} (h1).
+using Bitboard = uint64_t;
+
+#define SQUARE(row, col) ((row) * 8 + (col))
+#define ROW_OF(square) ((square) >> 3)
+#define COL_OF(square) ((square) & 7)
+#define SQUARE_BB(square) (static_cast<Bitboard>(1) << (square))
+
+namespace bitboard
+{
+    inline int popCount(Bitboard b)
+    {
+#if defined(_MSC_VER)
+        return static_cast<int>(__popcnt64(b));
+#else
+        return __builtin_popcountll(b);
+#endif
+    }
+
+    /// @brief index of the least significant set bit. undefined for an empty bitboard.
+    inline int lsb(Bitboard b)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward64(&index, b);
+        return static_cast<int>(index);
+#else
+        return __builtin_ctzll(b);
+#endif
+    }
+
+    /// @brief removes the least significant set bit and returns its index.
+    inline int popLsb(Bitboard &b)
+    {
+        int square = lsb(b);
+        b &= b - 1;
+        return square;
+    }
+}
+
+/// @brief the bitboard core of a position.
+/// one bitboard per piece (indexed by Piece - 1), occupancy per colour, and a mailbox
+/// so that "what is on this square" stays a single array read.
+struct Bitboards
+{
+    std::array<Bitboard, 12> m_pieces{};
+    std::array<Bitboard, 2> m_occupancy{};
+    std::array<Piece, 64> m_mailbox{}; // value initialized to Piece::EMPTY
+
+    Bitboard pieces(Piece p) const { return m_pieces[p - 1]; }
+    Bitboard occupied() const { return m_occupancy[PlayerColor::White] | m_occupancy[PlayerColor::Black]; }
+    Piece at(int square) const { return m_mailbox[square]; }
+
+    void put(Piece p, int square)
+    {
+        Bitboard bb = SQUARE_BB(square);
+        m_pieces[p - 1] |= bb;
+        m_occupancy[getPieceColor(p)] |= bb;
+        m_mailbox[square] = p;
+    }
+
+    void remove(int square)
+    {
+        Piece p = m_mailbox[square];
+        if (p == Piece::EMPTY)
+            return;
+        Bitboard bb = SQUARE_BB(square);
+        m_pieces[p - 1] &= ~bb;
+        m_occupancy[getPieceColor(p)] &= ~bb;
+        m_mailbox[square] = Piece::EMPTY;
+    }
+
+    void clear()
+    {
+        m_pieces.fill(0);
+        m_occupancy.fill(0);
+        m_mailbox.fill(Piece::EMPTY);
+    }
+};
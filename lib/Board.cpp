@@ -2,14 +2,20 @@
 #include "Board.h"
 #include "PlayerColor.h"
 #include "Move.h"
+#include "Attacks.h"
+#include "Cuckoo.h"
+#include "Zobrist.h"
+
+#include <cassert>
+#include <cstdlib>
 
 #define IN_RANGE(num) (0 <= num && num < 8)
 #define IS_ON_BOARD(row, col) (IN_RANGE(row) && IN_RANGE(col))
-#define IS_WHITE(row, col) (Piece::WHITE_PAWN <= m_board[row][col] && m_board[row][col] <= Piece::WHITE_KING)
-#define IS_EMPTY(row, col) (Piece::EMPTY == m_board[row][col])
-#define BREAK_IF_TARGET_COLOR(dest, target) \
-    if (dest == target)                     \
-        break;
+#define PIECE_AT(row, col) (m_bitboards.m_mailbox[SQUARE(row, col)])
+#define IS_WHITE(row, col) (m_bitboards.m_occupancy[PlayerColor::White] & SQUARE_BB(SQUARE(row, col)))
+#define IS_EMPTY(row, col) (Piece::EMPTY == PIECE_AT(row, col))
+// the black pieces are the white ones shifted up by 6 in the enum
+#define COLORED(whitePiece, color) static_cast<Piece>((whitePiece) + 6 * (color))
 
 PlayerColor Board::getColor(int row, int col)
 {
@@ -22,187 +28,105 @@ PlayerColor Board::getColor(int row, int col)
     return PlayerColor::None;
 }
 
-void Board::addRookMoves(std::vector<Move> &moves, const PlayerColor &playerToMove, const std::pair<int, int> &position)
+void Board::addAttackMoves(MoveList &moves, const PlayerColor &playerToMove, int from, Bitboard targets)
 {
-    PlayerColor targetColor = playerToMove == PlayerColor::White ? PlayerColor::Black : PlayerColor::White;
-
-    int row = position.first + 1;
-    int col = position.second;
-
-    PlayerColor color = getColor(row, col);
-    // check down
-    while (IS_ON_BOARD(row,col) && !(color == playerToMove))
+    // can't take our own pieces
+    targets &= ~m_bitboards.m_occupancy[playerToMove];
+    while (targets)
     {
-        // decrement row
-        moves.emplace_back(playerToMove, m_board[position.first][position.second], m_board[row][col], position, row, col);
-        BREAK_IF_TARGET_COLOR(color, targetColor);
-        row++;
-        color = getColor(row, col);
-    }
-    // check up
-    row = position.first - 1;
-    color = getColor(row, col);
-    while (IS_ON_BOARD(row,col) && !(color == playerToMove))
-    {
-        moves.emplace_back(playerToMove, m_board[position.first][position.second], m_board[row][col], position, row, col);
-        BREAK_IF_TARGET_COLOR(color, targetColor);
-        row--;
-        color = getColor(row, col);
-    }
-    row = position.first;
-    // col = position.second - 1;
-    col = position.second -1;
-    color = getColor(row, col);
-    // check left
-    while (IS_ON_BOARD(row,col) && !(color == playerToMove))
-    {
-        moves.emplace_back(playerToMove, m_board[position.first][position.second], m_board[row][col], position, row, col);
-        BREAK_IF_TARGET_COLOR(color, targetColor);
-        col--;
-        color = getColor(row, col);
-    }
-    col = position.second + 1;
-    color = getColor(row, col);
-    // check right
-    while (IS_ON_BOARD(row,col) && !(color == playerToMove))
-    {
-        // if color at dest is target color, break
-        moves.emplace_back(playerToMove, m_board[position.first][position.second], m_board[row][col], position, row, col);
-        BREAK_IF_TARGET_COLOR(color, targetColor);
-        col++;
-        color = getColor(row, col);
+        int square = bitboard::popLsb(targets);
+        moves.emplace_back(from, square, m_bitboards.at(square) != Piece::EMPTY ? Move::CAPTURE : Move::QUIET);
     }
 }
 
-void Board::addBishopMoves(std::vector<Move> &moves, const PlayerColor &playerToMove, const std::pair<int, int> &position)
+void Board::addPawnMove(MoveList &moves, int from, int to)
 {
-    int row = position.first - 1;
-    int col = position.second + 1;
-
-    PlayerColor targetColor = playerToMove == PlayerColor::White ? PlayerColor::Black : PlayerColor::White;
-
-    PlayerColor color = getColor(row, col);
-    // check NE (row decrements, column increments)
-    while (IS_ON_BOARD(row, col) && !(color == playerToMove))
-    {
-        // decrement row
-        moves.emplace_back(playerToMove, m_board[position.first][position.second], m_board[row][col], position, row, col);
-        BREAK_IF_TARGET_COLOR(color, targetColor);
-        row--;
-        col++;
-        color = getColor(row, col);
-    }
-    // check NW (row decrements, column decrements)
-    row = position.first - 1;
-    col = position.second - 1;
-    color = getColor(row, col);
-    while (IS_ON_BOARD(row, col) && !(color == playerToMove))
-    {
-        moves.emplace_back(playerToMove, m_board[position.first][position.second], m_board[row][col], position, row, col);
-        BREAK_IF_TARGET_COLOR(color, targetColor);
-        row--;
-        col--;
-        color = getColor(row, col);
-    }
-    row = position.first + 1;
-    col = position.second + 1;
-    color = getColor(row, col);
-    // check SE (row increments, column increments)
-    while (IS_ON_BOARD(row, col) && !(color == playerToMove))
+    uint8_t capture = m_bitboards.at(to) != Piece::EMPTY ? Move::CAPTURE : Move::QUIET;
+    int row = ROW_OF(to);
+    if (row == 0 || row == 7)
     {
-        moves.emplace_back(playerToMove, m_board[position.first][position.second], m_board[row][col], position, row, col);
-        BREAK_IF_TARGET_COLOR(color, targetColor);
-        row++;
-        col++;
-        color = getColor(row, col);
-    }
-    row = position.first + 1;
-    col = position.second - 1;
-    color = getColor(row, col);
-    // check SW (row increments, column decrements)
-    while (IS_ON_BOARD(row, col) && !(color == playerToMove))
-    {
-        moves.emplace_back(playerToMove, m_board[position.first][position.second], m_board[row][col], position, row, col);
-        BREAK_IF_TARGET_COLOR(color, targetColor);
-        row++;
-        col--;
-        color = getColor(row, col);
+        // reaching the last row, the pawn has to become one of these
+        for (uint8_t promotion : {Move::QUEEN_PROMOTION, Move::ROOK_PROMOTION, Move::BISHOP_PROMOTION, Move::KNIGHT_PROMOTION})
+        {
+            moves.emplace_back(from, to, promotion | capture);
+        }
+        return;
     }
+    moves.emplace_back(from, to, capture);
 }
 
-void Board::addPawnMoves(std::vector<Move> &moves, const PlayerColor &playerToMove, const std::pair<int, int> &position)
+void Board::addPawnMoves(MoveList &moves, const PlayerColor &playerToMove, int from, Bitboard legalMask, bool enPassant)
 {
-    /* TODO implement in passing */
-    /* TODO implement 2 move if haven't moved yet*/
-
-    int rowOffset = playerToMove == PlayerColor::White ? -1 : 1;
-
-    
+    int homeRow = playerToMove == PlayerColor::White ? 6 : 1;
 
     PlayerColor targetColor = playerToMove == PlayerColor::White ? PlayerColor::Black : PlayerColor::White;
+    const int fromRow = ROW_OF(from);
+    const Bitboard empty = ~m_bitboards.occupied();
 
-
-    /* home row */
-    int row = position.first + (rowOffset * 2); // target row
-    if ((position.first == 1 || position.first == 6) && IS_EMPTY(row, position.second) && IS_ON_BOARD(row,position.second))
-    {
-        moves.emplace_back(playerToMove, m_board[position.first][position.second], m_board[row][position.second], position, row, position.second);
-    }
-
-    row = position.first + rowOffset;
     /* moving up/down */
-    if (IS_EMPTY(row, position.second) && IS_ON_BOARD(row,position.second))
+    Bitboard push = attacks::pawnPushes[playerToMove][from] & empty;
+    if (push)
     {
-        moves.emplace_back(playerToMove, m_board[position.first][position.second], m_board[row][position.second], position, row, position.second);
-    }
-
+        int to = bitboard::lsb(push);
+        if (legalMask & push)
+            addPawnMove(moves, from, to);
 
+        /* home row: two squares, as long as both are empty */
+        Bitboard doublePush = attacks::pawnPushes[playerToMove][to] & empty & legalMask;
+        if (fromRow == homeRow && doublePush)
+        {
+            moves.emplace_back(from, bitboard::lsb(doublePush), Move::DOUBLE_PUSH);
+        }
+    }
 
-    int col = position.second + 1;
     /* taking pieces */
-    if ((getColor(row, col) == targetColor) && IS_ON_BOARD(row, col))
+    Bitboard captures = attacks::pawnAttacks[playerToMove][from] & m_bitboards.m_occupancy[targetColor] & legalMask;
+    while (captures)
     {
-        // push back
-        moves.emplace_back(playerToMove, m_board[position.first][position.second], m_board[row][col], position, row, col);
+        addPawnMove(moves, from, bitboard::popLsb(captures));
     }
-    col = position.second - 1;
-    if ((getColor(row, col) == targetColor) && IS_ON_BOARD(row, col))
-    {
-        moves.emplace_back(playerToMove, m_board[position.first][position.second], m_board[row][col], position, row, col);
-    }
-}
-
-// offset constants
-static const std::vector<std::pair<int, int>> knightOffsets{{2, 1}, {2, -1}, {-2, 1}, {-2, -1}, {1, 2}, {1, -2}, {-1, 2}, {-1, -2}};
 
-void Board::addKnightMoves(std::vector<Move> &moves, const PlayerColor &playerToMove, const std::pair<int, int> &position)
-{
-    for (auto &x : knightOffsets)
+    int enPassantSquare = enPassant ? getEnPassantSquare() : -1;
+    if (enPassantSquare >= 0 && (attacks::pawnAttacks[playerToMove][from] & SQUARE_BB(enPassantSquare)))
     {
-        int row = position.first + x.first;
-        int col = position.second + x.second;
-        if (IS_ON_BOARD(row, col) && !(getColor(row, col) == playerToMove))
+        // in passing: the pawn taken is beside us, not on the destination square.
+        // two pieces leave the row at once, so check the king directly instead of with the masks
+        int taken = SQUARE(fromRow, COL_OF(enPassantSquare));
+        Bitboard kings = m_bitboards.pieces(COLORED(Piece::WHITE_KING, playerToMove));
+        if (kings)
         {
-            moves.emplace_back(playerToMove, m_board[position.first][position.second], m_board[row][col], position, row, col);
+            Bitboard occupied = (m_bitboards.occupied() ^ SQUARE_BB(from) ^ SQUARE_BB(taken)) | SQUARE_BB(enPassantSquare);
+            Bitboard attackers = attackersTo(bitboard::lsb(kings), occupied) & m_bitboards.m_occupancy[targetColor] & ~SQUARE_BB(taken);
+            if (attackers)
+                return;
         }
+        moves.emplace_back(from, enPassantSquare, Move::EN_PASSANT);
     }
 }
 
-static const std::vector<std::pair<int, int>> kingOffsets{{0, 1}, {0, -1}, {1, 0}, {-1, 0}, {1, 1}, {-1, 1}, {1, -1}, {-1, -1}};
-
-void Board::addKingMoves(std::vector<Move> &moves, const PlayerColor &playerToMove, const std::pair<int, int> &position)
+void Board::addKingMoves(MoveList &moves, const PlayerColor &playerToMove, int from, MoveType type)
 {
-    std::vector<Move> options;
-    // all around the position, as long as it's not the same color
-    for (auto &x : kingOffsets)
+    PlayerColor targetColor = playerToMove == PlayerColor::White ? PlayerColor::Black : PlayerColor::White;
+    const std::pair<int, int> position{ROW_OF(from), COL_OF(from)};
+
+    // all around the position, as long as it's not the same color and not attacked.
+    // the king is taken off the board first so it can't hide behind itself on a slider's ray
+    Bitboard occupied = m_bitboards.occupied() ^ SQUARE_BB(from);
+    Bitboard targets = attacks::kingAttacks[from] & ~m_bitboards.m_occupancy[playerToMove];
+    if (type == MoveType::Captures)
+        targets &= m_bitboards.m_occupancy[targetColor];
+    else if (type == MoveType::Quiets)
+        targets &= ~m_bitboards.m_occupancy[targetColor];
+    while (targets)
     {
-        int row = position.first + x.first;
-        int col = position.second + x.second;
-        if (IS_ON_BOARD(row, col) && !(getColor(row, col) == playerToMove))
+        int square = bitboard::popLsb(targets);
+        if (!(attackersTo(square, occupied) & m_bitboards.m_occupancy[targetColor]))
         {
-            options.emplace_back(playerToMove, m_board[position.first][position.second], m_board[row][col], position, row, col);
+            moves.emplace_back(from, square, m_bitboards.at(square) != Piece::EMPTY ? Move::CAPTURE : Move::QUIET);
         }
     }
+    if (type == MoveType::Captures)
+        return;
 
     /* king castling */
     Piece king = (playerToMove == PlayerColor::White) ? Piece::WHITE_KING : Piece::BLACK_KING;
@@ -212,184 +136,192 @@ void Board::addKingMoves(std::vector<Move> &moves, const PlayerColor &playerToMo
     bool isQueensideAllowed{false};
 
     int row = (playerToMove == PlayerColor::White) ? 7 : 0 ;
+    uint8_t kingside = (playerToMove == PlayerColor::White) ? CastlingRights::WHITE_KINGSIDE : CastlingRights::BLACK_KINGSIDE;
+    uint8_t queenside = (playerToMove == PlayerColor::White) ? CastlingRights::WHITE_QUEENSIDE : CastlingRights::BLACK_QUEENSIDE;
+    bool isKingHome = position == std::pair<int, int>{row, 4} && PIECE_AT(row, 4) == king;
+    uint8_t rights = isKingHome ? getCastlingRights() : 0;
 
-    if ((IS_EMPTY(row,1) && IS_EMPTY(row,2) && IS_EMPTY(row,3)) && (m_board[row][0] == rook))
+    if ((rights & queenside) && (IS_EMPTY(row,1) && IS_EMPTY(row,2) && IS_EMPTY(row,3)) && (PIECE_AT(row, 0) == rook))
     {
         isQueensideAllowed = true;
     }
 
-    if (IS_EMPTY(row,5) && IS_EMPTY(row,6) && (m_board[row][7] == rook))
+    if ((rights & kingside) && IS_EMPTY(row,5) && IS_EMPTY(row,6) && (PIECE_AT(row, 7) == rook))
     {
         isKingsideAllowed = true;
     }
 
-
-    if ((isKingsideAllowed || isQueensideAllowed) && !isInCheck(playerToMove))
+    // criteria:
+    // - neither king nor rook have moved yet
+    // - king is not in check
+    // - king does not cross over a square attacked by enemy piece // does not end up in check
+    if ((isKingsideAllowed || isQueensideAllowed) && !isUnderAttack(playerToMove, position))
     {
-        // first and foremost, check if king has moved
-        // check if either rook has moved
-        // we can assume the position! saves a tiny bit of work lol
-
-        for (const auto& move : m_previousMoves)
+        if (isKingsideAllowed && !isUnderAttack(playerToMove, {row, 5}) && !isUnderAttack(playerToMove, {row, 6}))
         {
-            if (move.m_piece == king)
-            {
-                isKingsideAllowed = false;
-                isQueensideAllowed = false;
-                break;
-            }
-            if (move.m_piece == rook)
-            {
-                if (move.m_start.second == 0)
-                {
-                    isQueensideAllowed = false;
-                }
-                if (move.m_start.second == 7)
-                {
-                    isKingsideAllowed = false;
-                }
-            }
-            
-        }
-        if (isKingsideAllowed)
-        {
-            if (!isUnderAttack(playerToMove,{row,5}))
-            {
-                options.emplace_back(playerToMove, m_board[position.first][position.second], m_board[row][6], position, row, 6, true);
-            }
+            moves.emplace_back(from, SQUARE(row, 6), Move::KINGSIDE_CASTLE);
         }
 
-        if (isQueensideAllowed)
+        if (isQueensideAllowed && !isUnderAttack(playerToMove, {row, 3}) && !isUnderAttack(playerToMove, {row, 2}))
         {
-            // make sure all the crossing squares are safe
-            if (!isUnderAttack(playerToMove,{row,3}))
-            {
-                options.emplace_back(playerToMove, m_board[position.first][position.second], m_board[row][2], position, row, 2, true);
-            }
+            moves.emplace_back(from, SQUARE(row, 2), Move::QUEENSIDE_CASTLE);
         }
+    }
+}
 
-        // check crossing squares of allowed sides
+Bitboard Board::attackersTo(int square, Bitboard occupied) const
+{
+    // look outwards from the square with each piece's attack pattern:
+    // if it lands on a piece of that type, that piece attacks the square
+    Bitboard rooks = m_bitboards.pieces(Piece::WHITE_ROOK) | m_bitboards.pieces(Piece::BLACK_ROOK) |
+                     m_bitboards.pieces(Piece::WHITE_QUEEN) | m_bitboards.pieces(Piece::BLACK_QUEEN);
+    Bitboard bishops = m_bitboards.pieces(Piece::WHITE_BISHOP) | m_bitboards.pieces(Piece::BLACK_BISHOP) |
+                       m_bitboards.pieces(Piece::WHITE_QUEEN) | m_bitboards.pieces(Piece::BLACK_QUEEN);
+
+    return (attacks::pawnAttacks[PlayerColor::White][square] & m_bitboards.pieces(Piece::BLACK_PAWN)) |
+           (attacks::pawnAttacks[PlayerColor::Black][square] & m_bitboards.pieces(Piece::WHITE_PAWN)) |
+           (attacks::knightAttacks[square] & (m_bitboards.pieces(Piece::WHITE_KNIGHT) | m_bitboards.pieces(Piece::BLACK_KNIGHT))) |
+           (attacks::kingAttacks[square] & (m_bitboards.pieces(Piece::WHITE_KING) | m_bitboards.pieces(Piece::BLACK_KING))) |
+           (attacks::rookAttacks(square, occupied) & rooks) |
+           (attacks::bishopAttacks(square, occupied) & bishops);
+}
 
-        // criteria:
-        // - neither king nor rook have moved yet
-        // - king is not in check
-        // - king does not cross over a square attacked by enemy piece // does not end up in check
-    }
+bool Board::isUnderAttack(PlayerColor playerUnderAttack, std::pair<int,int> square)
+{
+    PlayerColor targetColor = playerUnderAttack == PlayerColor::White ? PlayerColor::Black : PlayerColor::White;
+    return attackersTo(SQUARE(square.first, square.second), m_bitboards.occupied()) & m_bitboards.m_occupancy[targetColor];
+}
 
+// legal moves without simulating them:
+// - the checkers and pinned pieces are worked out once, from the king outwards
+// - in double check only the king can move
+// - in single check every other move has to take the checker or block its ray (the check mask)
+// - a pinned piece can only move along the line between its king and the pinning piece
+// - the king only steps onto squares that aren't attacked
+void Board::getLegalMoves(MoveList &moves)
+{
+    generateLegalMoves(moves, MoveType::All);
+}
 
+void Board::getLegalCaptures(MoveList &moves)
+{
+    generateLegalMoves(moves, MoveType::Captures);
+}
 
+void Board::getLegalQuiets(MoveList &moves)
+{
+    generateLegalMoves(moves, MoveType::Quiets);
+}
 
-    /* unfortunately this is rather expensive */
-    Board copy = (*this);
-    for (auto &move : options)
-    {
-        copy.move(move);
-        if (!copy.isInCheck(playerToMove))
-        {
-            // the move is legal
-            moves.emplace_back(move);
-        }
-        copy.undo();
-    }
+void Board::getLegalMovesFrom(MoveList &moves, Bitboard from)
+{
+    generateLegalMoves(moves, MoveType::All, from);
 }
 
+bool Board::isLegal(Move move)
+{
+    if (move.isNull() || getPieceColor(m_bitboards.at(move.start())) != getPlayerToMove())
+        return false;
+    // only the moving piece's moves
+    MoveList moves;
+    generateLegalMoves(moves, MoveType::All, SQUARE_BB(move.start()));
+    return std::find(moves.begin(), moves.end(), move) != moves.end();
+}
 
-bool Board::isUnderAttack(PlayerColor playerUnderAttack, std::pair<int,int> square)
+void Board::generateLegalMoves(MoveList &moves, MoveType type, Bitboard fromMask)
 {
+    const PlayerColor us = getPlayerToMove();
+    const PlayerColor them = us == PlayerColor::White ? PlayerColor::Black : PlayerColor::White;
 
-    PlayerColor targetColor = playerUnderAttack == PlayerColor::White ? PlayerColor::Black : PlayerColor::White;
+    const Bitboard occupied = m_bitboards.occupied();
+    const Bitboard kings = m_bitboards.pieces(COLORED(Piece::WHITE_KING, us));
 
-    std::vector<Move> opponentMoves;
+    Bitboard checkers = 0;
+    Bitboard pinned = 0;
+    Bitboard checkMask = ~static_cast<Bitboard>(0);
+    int king = -1;
 
-    for (int i =0; IN_RANGE(i); i++)
+    if (kings)
     {
-        for (int j=0; IN_RANGE(i); i++)
+        king = bitboard::lsb(kings);
+        checkers = attackersTo(king, occupied) & m_bitboards.m_occupancy[them];
+
+        // sliders that would see the king on an empty board pin a piece if exactly one of ours is in the way
+        Bitboard queens = m_bitboards.pieces(COLORED(Piece::WHITE_QUEEN, them));
+        Bitboard snipers = (attacks::rookAttacks(king, 0) & (m_bitboards.pieces(COLORED(Piece::WHITE_ROOK, them)) | queens)) |
+                           (attacks::bishopAttacks(king, 0) & (m_bitboards.pieces(COLORED(Piece::WHITE_BISHOP, them)) | queens));
+        while (snipers)
         {
-            
-            if (getColor(i, j) == targetColor) // if opponent's piece
-            {
-                // add the moves to the list of targetMoves
-                getMoves(opponentMoves, targetColor, {i, j}, false); // may need to change flag
-            }
-
+            int sniper = bitboard::popLsb(snipers);
+            Bitboard blockers = attacks::between[king][sniper] & occupied;
+            if (bitboard::popCount(blockers) == 1)
+                pinned |= blockers & m_bitboards.m_occupancy[us];
         }
     }
 
-    // need to filter results to see if any match the position passed as argument
-    // if any of opponents moves can target the king, return true
-    for (const auto &move : opponentMoves)
+    // every king gets its moves, not just the one checks are measured against (test and editor positions can have two)
+    Bitboard ourKings = kings & fromMask;
+    while (ourKings)
     {
-            if (move.m_dest == square)
-            {
-                return true;
-            }            
+        int square = bitboard::popLsb(ourKings);
+        addKingMoves(moves, us, square, type);
     }
-    return false;
-}
 
-void Board::getMoves(std::vector<Move> &moves, const PlayerColor playerToMove, std::pair<int, int> position, bool includeKing)
-{
-    const Piece piece = m_board[position.first][position.second];
-    // there's two ways out of this mess:
-    // - encode the color of the piece in the piece enum
-    // - switch to polymorphic piece representation?
-    if (getColor(position.first, position.second) != playerToMove)
+    if (bitboard::popCount(checkers) > 1)
         return;
+    if (checkers)
+        checkMask = attacks::between[king][bitboard::lsb(checkers)] | checkers;
+    // captures only go to squares with something to take (though pawns also promote, and take in passing),
+    // quiet moves only to empty squares short of promoting
+    const Bitboard lastRows = 0xFFULL | 0xFFULL << 56;
+    Bitboard targetMask = ~static_cast<Bitboard>(0);
+    Bitboard pawnTargetMask = targetMask;
+    if (type == MoveType::Captures)
+    {
+        targetMask = m_bitboards.m_occupancy[them];
+        pawnTargetMask = targetMask | lastRows;
+    }
+    else if (type == MoveType::Quiets)
+    {
+        targetMask = ~occupied;
+        pawnTargetMask = targetMask & ~lastRows;
+    }
 
-    switch (piece)
-    {
-    // all the possible moves for the white pieces
-    case (Piece::EMPTY):
-        return; // not a piece -> no moves!!!
-    // find pawn moves
-    case (Piece::BLACK_PAWN):
-    case (Piece::WHITE_PAWN):
-        // find pawn moves, add to vector
-        addPawnMoves(moves, playerToMove, position);
-        break;
-    // find rook moves
-    case (Piece::BLACK_ROOK):
-    case (Piece::WHITE_ROOK):
-        addRookMoves(moves, playerToMove, position);
-        break;
-    // find knight moves
-    case (Piece::BLACK_KNIGHT):
-    case (Piece::WHITE_KNIGHT):
-        addKnightMoves(moves, playerToMove, position);
-        break;
-    // find bishop moves
-    case (Piece::BLACK_BISHOP):
-    case (Piece::WHITE_BISHOP):
-        addBishopMoves(moves, playerToMove, position);
-        break;
-    // find queen moves
-    case (Piece::BLACK_QUEEN):
-    case (Piece::WHITE_QUEEN):
-        addBishopMoves(moves, playerToMove, position);
-        addRookMoves(moves, playerToMove, position);
-        break;
-    // find king moves
-    case (Piece::BLACK_KING):
-    case (Piece::WHITE_KING):
-        if (includeKing)
-            addKingMoves(moves, playerToMove, position);
-        break;
-    default:
-        break;
-    }
-}
-
-// how to calculate if a player is in check
-// - calculate opponents moves
-// - if one of target pieces is the king, the player is in check
-// - only moves that result in king no longer being under attack is playable
-
-// every time a move is made, calculate both players possible moves
-// when a player selects a piece, just show the subset
-
-// we need some sort of api to simulate making a move
-// copy constructor for board (maybe a lighter version of the board class)
-// from the copy we can calculate possible moves
+    Bitboard pieces = m_bitboards.m_occupancy[us] & ~kings & fromMask;
+    while (pieces)
+    {
+        int from = bitboard::popLsb(pieces);
+        Bitboard legalMask = checkMask;
+        if (pinned & SQUARE_BB(from))
+            legalMask &= attacks::line[king][from];
+
+        switch (m_bitboards.at(from))
+        {
+        case (Piece::BLACK_PAWN):
+        case (Piece::WHITE_PAWN):
+            addPawnMoves(moves, us, from, legalMask & pawnTargetMask, type != MoveType::Quiets);
+            break;
+        case (Piece::BLACK_ROOK):
+        case (Piece::WHITE_ROOK):
+            addAttackMoves(moves, us, from, attacks::rookAttacks(from, occupied) & legalMask & targetMask);
+            break;
+        case (Piece::BLACK_KNIGHT):
+        case (Piece::WHITE_KNIGHT):
+            addAttackMoves(moves, us, from, attacks::knightAttacks[from] & legalMask & targetMask);
+            break;
+        case (Piece::BLACK_BISHOP):
+        case (Piece::WHITE_BISHOP):
+            addAttackMoves(moves, us, from, attacks::bishopAttacks(from, occupied) & legalMask & targetMask);
+            break;
+        case (Piece::BLACK_QUEEN):
+        case (Piece::WHITE_QUEEN):
+            addAttackMoves(moves, us, from, attacks::queenAttacks(from, occupied) & legalMask & targetMask);
+            break;
+        default:
+            break;
+        }
+    }
+}
 
 void Board::setValidMoves(std::pair<int, int> position)
 {
@@ -399,99 +331,202 @@ void Board::setValidMoves(std::pair<int, int> position)
         std::cout << "Error at setValidMoves: Invalid position."  << std::endl;
         return;
     }
-    const Piece piece = m_board[position.first][position.second];
-    const PlayerColor l_playerToMove = getPlayerToMove();
 
-    getMoves(m_availableMoves, l_playerToMove, position, true);
-
-    // filters out moves that place player in check
-        /* unfortunately this is rather expensive */
-    Board copy = (*this);
-    for (int i = 0; i < m_availableMoves.size();)
+    for (const Move &move : legalMoves())
     {
-        copy.move(m_availableMoves[i]);
-        if (copy.isInCheck(l_playerToMove))
-        {
-            // the move is legal
-            m_availableMoves.erase(std::begin(m_availableMoves) + i);
-        } else {
-            i++;
-        }
-        copy.undo();
+        if (move.startPosition() == position)
+            m_availableMoves.push_back(move);
     }
+}
 
+const MoveList &Board::legalMoves()
+{
+    if (!m_legalMovesValid)
+    {
+        m_legalMoves.clear();
+        getLegalMoves(m_legalMoves);
+        m_legalMovesValid = true;
+    }
+    return m_legalMoves;
 }
 
 const PlayerColor Board::getPlayerToMove() const
 {
-    return m_previousMoves.size() % 2 == 0 ? PlayerColor::White : PlayerColor::Black;
+    return m_sideToMove;
 }
 
-bool Board::isInCheck(PlayerColor playerToMove)
+// the castling rights each square keeps when a piece leaves or lands on it:
+// the king and rook home squares lose the rights that need that piece unmoved
+static const uint8_t castlingMask[64] = {
+    15 & ~CastlingRights::BLACK_QUEENSIDE, 15, 15, 15, 15 & ~(CastlingRights::BLACK_KINGSIDE | CastlingRights::BLACK_QUEENSIDE), 15, 15, 15 & ~CastlingRights::BLACK_KINGSIDE,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15 & ~CastlingRights::WHITE_QUEENSIDE, 15, 15, 15, 15 & ~(CastlingRights::WHITE_KINGSIDE | CastlingRights::WHITE_QUEENSIDE), 15, 15, 15 & ~CastlingRights::WHITE_KINGSIDE};
+
+uint64_t Board::enPassantKey() const
 {
-    PlayerColor targetColor = playerToMove == PlayerColor::White ? PlayerColor::Black : PlayerColor::White;
+    int square = getEnPassantSquare();
+    if (square < 0)
+        return 0;
+
+    // only hashed when a pawn can actually take, so positions that differ in nothing else hash the same
+    PlayerColor justMoved = m_sideToMove == PlayerColor::White ? PlayerColor::Black : PlayerColor::White;
+    if (attacks::pawnAttacks[justMoved][square] & m_bitboards.pieces(COLORED(Piece::WHITE_PAWN, m_sideToMove)))
+        return zobrist::keys.m_enPassantFile[COL_OF(square)];
+    return 0;
+}
 
-    Piece king = (playerToMove == PlayerColor::White) ? Piece::WHITE_KING : Piece::BLACK_KING;
-    Piece opponentKing = (playerToMove == PlayerColor::White) ? Piece::BLACK_KING : Piece::WHITE_KING;
+uint64_t Board::computeHash() const
+{
+    uint64_t hash = 0;
+    Bitboard occupied = m_bitboards.occupied();
+    while (occupied)
+    {
+        int square = bitboard::popLsb(occupied);
+        hash ^= zobrist::piece(m_bitboards.at(square), square);
+    }
+    if (m_sideToMove == PlayerColor::Black)
+        hash ^= zobrist::keys.m_sideToMove;
+    hash ^= zobrist::keys.m_castling[getCastlingRights()];
+    hash ^= enPassantKey();
+    return hash;
+}
 
-    std::pair<int, int> position{0,0};
-    std::vector<Move> opponentMoves;
-    // union together all of the moves that belong to target color's pieces
-    for (int i = 0; IN_RANGE(i); i++)
+uint64_t Board::computePawnHash() const
+{
+    uint64_t hash = 0;
+    for (Piece pawn : {Piece::WHITE_PAWN, Piece::BLACK_PAWN})
     {
-        for (int j = 0; IN_RANGE(j); j++)
-        {
-            if (m_board[i][j] == king)
-            {
-                position = {i, j};
-            }
+        Bitboard pawns = m_bitboards.pieces(pawn);
+        while (pawns)
+            hash ^= zobrist::piece(pawn, bitboard::popLsb(pawns));
+    }
+    return hash;
+}
 
-            if (m_board[i][j] == opponentKing) // restrict king from moving into opponent kings area
-            {
-                for (auto &offset : kingOffsets)
-                {
-                    if (IS_ON_BOARD(i + offset.first, j + offset.second))
-                        opponentMoves.emplace_back(targetColor, m_board[i][j], m_board[i + offset.first][j + offset.second], position, i + offset.first, j + offset.second);
-                }
-            }
+eval::Score Board::computePsq() const
+{
+    eval::Score psq;
+    Bitboard occupied = m_bitboards.occupied();
+    while (occupied)
+    {
+        int square = bitboard::popLsb(occupied);
+        psq += eval::psq.m_scores[m_bitboards.at(square)][square];
+    }
+    return psq;
+}
+
+void Board::refreshState()
+{
+    m_hash = m_states.back().m_hash = computeHash();
+    m_pawnHash = computePawnHash();
+    m_psq = computePsq();
+    m_phase = 0;
+    for (int square = 0; square < 64; square++)
+        m_phase += eval::phaseWeight[m_bitboards.at(square)];
+    m_accumulators.clear();
+    m_legalMovesValid = false;
+}
 
-            if (getColor(i, j) == targetColor) // if opponent's piece
+void Board::invalidateAccumulator()
+{
+    size_t ply = m_states.size() - 1;
+    if (ply < m_accumulators.size())
+        m_accumulators[ply].m_computed[PlayerColor::White] = m_accumulators[ply].m_computed[PlayerColor::Black] = false;
+}
+
+const nnue::Accumulator &Board::getAccumulator() const
+{
+    if (m_accumulatorGeneration != nnue::generation())
+    {
+        m_accumulators.clear();
+        m_accumulatorGeneration = nnue::generation();
+    }
+    const size_t top = m_states.size() - 1;
+    if (m_accumulators.size() <= top)
+        m_accumulators.resize(top + 1);
+
+    for (PlayerColor perspective : {PlayerColor::White, PlayerColor::Black})
+    {
+        // find the last ply this side's half was worked out at. going back past a move of its own king
+        // changes every feature, so from there on it's cheaper to start again
+        const Piece king = COLORED(Piece::WHITE_KING, perspective);
+        size_t ply = top;
+        bool refresh = false;
+        while (!m_accumulators[ply].m_computed[perspective])
+        {
+            const nnue::DirtyPieces &dirty = m_states[ply].m_dirty;
+            bool kingMoved = false;
+            for (int i = 0; i < dirty.m_count; i++)
+                kingMoved |= dirty.m_changes[i].m_piece == king;
+            if (ply == 0 || kingMoved)
             {
-                // add the moves to the list of targetMoves
-                getMoves(opponentMoves, targetColor, {i, j}, false); // may need to change flag
+                refresh = true;
+                break;
             }
+            ply--;
         }
-    }
 
-    // if any of opponents moves can target the king, return true
-    for (auto &move : opponentMoves)
-    {
-        if (move.m_dest == position)
+        if (refresh)
         {
-            return true;
+            nnue::refresh(m_accumulators[top], m_bitboards, perspective);
+            continue;
         }
+        for (ply++; ply <= top; ply++)
+            nnue::update(m_accumulators[ply], m_accumulators[ply - 1], m_states[ply].m_dirty, m_bitboards, perspective);
     }
-    return false;
+    return m_accumulators[top];
+}
+
+void Board::putPiece(Piece piece, int square)
+{
+    m_bitboards.put(piece, square);
+    m_hash ^= zobrist::piece(piece, square);
+    if (piece == Piece::WHITE_PAWN || piece == Piece::BLACK_PAWN)
+        m_pawnHash ^= zobrist::piece(piece, square);
+    m_psq += eval::psq.m_scores[piece][square];
+    m_phase += eval::phaseWeight[piece];
+}
+
+void Board::removePiece(int square)
+{
+    Piece piece = m_bitboards.at(square);
+    if (piece == Piece::EMPTY)
+        return;
+    m_bitboards.remove(square);
+    m_hash ^= zobrist::piece(piece, square);
+    if (piece == Piece::WHITE_PAWN || piece == Piece::BLACK_PAWN)
+        m_pawnHash ^= zobrist::piece(piece, square);
+    m_psq -= eval::psq.m_scores[piece][square];
+    m_phase -= eval::phaseWeight[piece];
+}
+
+bool Board::isInCheck(PlayerColor playerToMove)
+{
+    Piece king = (playerToMove == PlayerColor::White) ? Piece::WHITE_KING : Piece::BLACK_KING;
+
+    Bitboard kings = m_bitboards.pieces(king);
+    if (!kings)
+        return false;
+    int kingSquare = bitboard::lsb(kings);
+    return isUnderAttack(playerToMove, {ROW_OF(kingSquare), COL_OF(kingSquare)});
 }
 
 bool Board::canKingMove(PlayerColor playerToMove)
 {
 
-    std::vector<Move> moves;
+    MoveList moves;
 
     Piece king = (playerToMove == PlayerColor::White) ? Piece::WHITE_KING : Piece::BLACK_KING;
 
-    std::pair<int, int> position;
-    // union together all of the moves that belong to target color's pieces
-    for (int i = 0; IN_RANGE(i); i++)
+    Bitboard kings = m_bitboards.pieces(king);
+    while (kings)
     {
-        for (int j = 0; IN_RANGE(j); j++)
-        {
-            if (m_board[i][j] == king)
-            {
-                getMoves(moves, playerToMove, {i, j}, true);
-            }
-        }
+        addKingMoves(moves, playerToMove, bitboard::popLsb(kings), MoveType::All);
     }
 
     return (moves.size() == 0) ? false : true;
@@ -499,53 +534,226 @@ bool Board::canKingMove(PlayerColor playerToMove)
 
 void Board::move(Move move)
 {
-    std::pair<int, int> dest = move.m_dest;
-    std::pair<int, int> start = move.m_start;
-
-    m_board[dest.first][dest.second] = m_board[start.first][start.second];
-    m_board[start.first][start.second] = Piece::EMPTY;
-    if (move.m_castling)
+    const int startSquare = move.start();
+    const int destSquare = move.dest();
+    const int row = ROW_OF(startSquare);
+    const PlayerColor us = m_sideToMove;
+    Piece piece = m_bitboards.at(startSquare);
+    // in passing, the pawn taken is beside the destination
+    const int takenSquare = move.isEnPassant() ? SQUARE(row, COL_OF(destSquare)) : destSquare;
+
+    StateInfo state;
+    state.m_move = move;
+    state.m_captured = m_bitboards.at(takenSquare);
+    // anything leaving or landing on the king / rook home squares means the piece there has moved or been taken
+    state.m_castling = getCastlingRights() & castlingMask[startSquare] & castlingMask[destSquare];
+    state.m_enPassant = move.isDoublePush() ? static_cast<int8_t>((startSquare + destSquare) / 2) : -1;
+    bool isPawn = piece == Piece::WHITE_PAWN || piece == Piece::BLACK_PAWN;
+    state.m_halfmoveClock = (isPawn || state.m_captured != Piece::EMPTY) ? 0 : getHalfmoveClock() + 1;
+    state.m_pliesFromNull = m_states.back().m_pliesFromNull + 1;
+
+    // the old rights and en passant file come out of the hash, the new ones go in at the end
+    m_hash ^= zobrist::keys.m_castling[getCastlingRights()] ^ enPassantKey();
+
+    if (state.m_captured != Piece::EMPTY)
+        state.m_dirty.add(state.m_captured, takenSquare, -1);
+    removePiece(takenSquare);
+    removePiece(startSquare);
+    if (move.isPromotion())
+    {
+        Piece promoted = COLORED(move.promotion(), us);
+        putPiece(promoted, destSquare);
+        state.m_dirty.add(piece, startSquare, -1);
+        state.m_dirty.add(promoted, -1, destSquare);
+    }
+    else
     {
-        // the above move is the king
-        // now we move rook
+        putPiece(piece, destSquare);
+        state.m_dirty.add(piece, startSquare, destSquare);
+    }
+    if (move.isCastling())
+    {
+        // the above move is the king, now the rook jumps over it
+        int rookFrom = move.flags() == Move::QUEENSIDE_CASTLE ? 0 : 7;
+        int rookTo = move.flags() == Move::QUEENSIDE_CASTLE ? 3 : 5;
+        Piece rook = m_bitboards.at(SQUARE(row, rookFrom));
+        removePiece(SQUARE(row, rookFrom));
+        putPiece(rook, SQUARE(row, rookTo));
+        state.m_dirty.add(rook, SQUARE(row, rookFrom), SQUARE(row, rookTo));
+    }
+    m_sideToMove = m_sideToMove == PlayerColor::White ? PlayerColor::Black : PlayerColor::White;
+    m_states.push_back(state);
+    invalidateAccumulator();
+    m_legalMovesValid = false;
+
+    m_hash ^= zobrist::keys.m_sideToMove ^ zobrist::keys.m_castling[state.m_castling] ^ enPassantKey();
+    m_states.back().m_hash = m_hash;
+    findRepetition();
+    assert(m_hash == computeHash());
+    assert(m_pawnHash == computePawnHash());
+    assert(m_psq == computePsq());
+
+    m_availableMoves.clear();
+    deselect();
+}
 
-        // check if queen side
-        if (move.m_dest.second == 2)
+void Board::makeNullMove()
+{
+    // nothing moves, the turn passes and any en passant chance is gone
+    StateInfo state = m_states.back();
+    state.m_move = Move();
+    state.m_captured = Piece::EMPTY;
+    state.m_enPassant = -1;
+    state.m_halfmoveClock++;
+    state.m_pliesFromNull = 0;
+    state.m_repetition = 0;
+    state.m_dirty = nnue::DirtyPieces{};
+
+    m_hash ^= enPassantKey() ^ zobrist::keys.m_sideToMove;
+    m_sideToMove = m_sideToMove == PlayerColor::White ? PlayerColor::Black : PlayerColor::White;
+    state.m_hash = m_hash;
+    m_states.push_back(state);
+    invalidateAccumulator();
+    m_legalMovesValid = false;
+    assert(m_hash == computeHash());
+}
+
+void Board::undo()
+{
+    if (m_states.size() == 1)
+    {
+        return;
+    }
+    const StateInfo &state = m_states.back();
+    const Move move = state.m_move;
+    m_sideToMove = m_sideToMove == PlayerColor::White ? PlayerColor::Black : PlayerColor::White;
+    if (!move.isNull())
+    {
+        const int startSquare = move.start();
+        const int destSquare = move.dest();
+        const int row = ROW_OF(startSquare);
+
+        // m_sideToMove is the side that made the move again
+        Piece piece = move.isPromotion() ? COLORED(Piece::WHITE_PAWN, m_sideToMove) : m_bitboards.at(destSquare);
+        removePiece(destSquare);
+        putPiece(piece, startSquare);
+        if (state.m_captured != Piece::EMPTY)
         {
-            m_board[move.m_dest.first][3] = m_board[start.first][0];
-            m_board[dest.first][0] = Piece::EMPTY;
+            putPiece(state.m_captured, move.isEnPassant() ? SQUARE(row, COL_OF(destSquare)) : destSquare);
         }
-        // check if king side
-        if (move.m_dest.second == 6)
+        if (move.isCastling())
         {
-            m_board[dest.first][5] = m_board[start.first][7];
-            m_board[start.first][7] = Piece::EMPTY;
+            // put the rook back in its corner
+            int rookFrom = move.flags() == Move::QUEENSIDE_CASTLE ? 3 : 5;
+            int rookTo = move.flags() == Move::QUEENSIDE_CASTLE ? 0 : 7;
+            Piece rook = m_bitboards.at(SQUARE(row, rookFrom));
+            removePiece(SQUARE(row, rookFrom));
+            putPiece(rook, SQUARE(row, rookTo));
+        }
+    }
+    m_states.pop_back();
+    m_legalMovesValid = false;
+
+    // everything else about the position comes straight back from the state below
+    m_hash = m_states.back().m_hash;
+    assert(m_hash == computeHash());
+    assert(m_pawnHash == computePawnHash());
+    assert(m_psq == computePsq());
+}
 
+void Board::findRepetition()
+{
+    // it can only be a position since the last capture or pawn move (or null move), with the same side to move
+    StateInfo &state = m_states.back();
+    const int last = static_cast<int>(m_states.size()) - 1;
+    const int end = std::min({static_cast<int>(state.m_halfmoveClock), static_cast<int>(state.m_pliesFromNull), last});
+    state.m_repetition = 0;
+    for (int i = 4; i <= end; i += 2)
+    {
+        const StateInfo &earlier = m_states[last - i];
+        if (earlier.m_hash == state.m_hash)
+        {
+            state.m_repetition = static_cast<int16_t>(earlier.m_repetition ? -i : i);
+            return;
         }
     }
-    m_previousMoves.push_back(move);
-    m_availableMoves.clear();
-    deselect();
 }
 
-void Board::undo()
+bool Board::isFiftyMoveDraw()
 {
-    if (m_previousMoves.size() == 0)
+    if (getHalfmoveClock() < 100)
+        return false;
+    if (!isInCheck(m_sideToMove))
+        return true;
+    MoveList moves;
+    getLegalMoves(moves);
+    return !moves.empty();
+}
+
+bool Board::isDraw(int ply)
+{
+    const int repetition = m_states.back().m_repetition;
+    return (repetition != 0 && repetition < ply) || isFiftyMoveDraw();
+}
+
+bool Board::hasUpcomingRepetition(int ply) const
+{
+    const StateInfo &state = m_states.back();
+    const int last = static_cast<int>(m_states.size()) - 1;
+    const int end = std::min({static_cast<int>(state.m_halfmoveClock), static_cast<int>(state.m_pliesFromNull), last});
+    if (end < 3)
+        return false;
+
+    // other is the hash change of the opponent's moves since then: only if they've all been undone (it's 0) can one
+    // of ours take the position back to what it was
+    uint64_t other = m_hash ^ m_states[last - 1].m_hash ^ zobrist::keys.m_sideToMove;
+    for (int i = 3; i <= end; i += 2)
     {
-        return;
+        other ^= m_states[last - i + 1].m_hash ^ m_states[last - i].m_hash ^ zobrist::keys.m_sideToMove;
+        if (other)
+            continue;
+
+        const uint64_t moveKey = m_hash ^ m_states[last - i].m_hash;
+        int slot = cuckoo::h1(moveKey);
+        if (cuckoo::table.m_keys[slot] != moveKey)
+            slot = cuckoo::h2(moveKey);
+        if (cuckoo::table.m_keys[slot] != moveKey)
+            continue;
+
+        // the piece has to have a clear way there
+        const int a = cuckoo::table.m_moves[slot] & 63;
+        const int b = cuckoo::table.m_moves[slot] >> 6;
+        if (attacks::between[a][b] & m_bitboards.occupied())
+            continue;
+        // inside the search any repetition counts. at or above the root it has to be one already, or the move
+        // just goes back to a position from the game once more
+        if (ply > i || m_states[last - i].m_repetition)
+            return true;
     }
-    Move move = *(std::prev(std::end(m_previousMoves)));
-    std::pair<int, int> dest = move.m_dest;
-    std::pair<int, int> start = move.m_start;
-    m_board[dest.first][dest.second] = move.m_takes;
-    m_board[start.first][start.second] = move.m_piece;
-    m_previousMoves.pop_back();
+    return false;
+}
+
+const std::vector<std::vector<Piece>> &Board::getBoard()
+{
+    m_boardView.assign(8, std::vector<Piece>(8, Piece::EMPTY));
+    for (int square = 0; square < 64; square++)
+    {
+        m_boardView[ROW_OF(square)][COL_OF(square)] = m_bitboards.at(square);
+    }
+    return m_boardView;
 }
 
 bool Board::isCheckmate(PlayerColor winner)
 {
-    PlayerColor opponentColor = winner == PlayerColor::White ? PlayerColor::Black : PlayerColor::White;
-    return (!canKingMove(opponentColor)) && isInCheck(opponentColor);
+    // only the player to move can be mated
+    if (winner == m_sideToMove)
+        return false;
+    return legalMoves().empty() && isInCheck(m_sideToMove);
+}
+
+bool Board::isStalemate()
+{
+    return legalMoves().empty() && !isInCheck(m_sideToMove);
 }
 
 void Board::select(int row, int col) 
@@ -562,3 +770,222 @@ void Board::deselect() {
     m_selection = DEFAULT_SELECTION;
     m_availableMoves.clear();
 } 
+
+static Piece pieceFromFen(char c)
+{
+    switch (c)
+    {
+    case 'P': return Piece::WHITE_PAWN;
+    case 'R': return Piece::WHITE_ROOK;
+    case 'N': return Piece::WHITE_KNIGHT;
+    case 'B': return Piece::WHITE_BISHOP;
+    case 'Q': return Piece::WHITE_QUEEN;
+    case 'K': return Piece::WHITE_KING;
+    case 'p': return Piece::BLACK_PAWN;
+    case 'r': return Piece::BLACK_ROOK;
+    case 'n': return Piece::BLACK_KNIGHT;
+    case 'b': return Piece::BLACK_BISHOP;
+    case 'q': return Piece::BLACK_QUEEN;
+    case 'k': return Piece::BLACK_KING;
+    default: return Piece::EMPTY;
+    }
+}
+
+// indexed by Piece
+static const char fenPieces[] = " PRNBQKprnbqk";
+
+Board::Board(const std::string &fen)
+{
+    if (!setFen(fen))
+    {
+        std::cout << "Error at Board: Invalid FEN " << fen << std::endl;
+    }
+}
+
+// a hand written scanner instead of a stringstream: positions are loaded by the million from EPD files
+bool Board::setFen(std::string_view fen, size_t *end)
+{
+    m_bitboards.clear();
+    m_states.resize(1);
+    m_states[0] = StateInfo{};
+    m_sideToMove = PlayerColor::White;
+    m_startPly = 0;
+    m_availableMoves.clear();
+    m_selection = DEFAULT_SELECTION;
+
+    size_t i = 0;
+    auto skipSpaces = [&]() {
+        while (i < fen.size() && (fen[i] == ' ' || fen[i] == '\t'))
+            i++;
+    };
+    auto fail = [&]() {
+        m_bitboards.clear();
+        refreshState();
+        if (end)
+            *end = i;
+        return false;
+    };
+
+    skipSpaces();
+    int row = 0;
+    int col = 0;
+    for (; i < fen.size() && fen[i] != ' '; i++)
+    {
+        char c = fen[i];
+        if (c == '/')
+        {
+            if (col != 8)
+                return fail();
+            row++;
+            col = 0;
+        }
+        else if ('1' <= c && c <= '8')
+        {
+            col += c - '0';
+        }
+        else
+        {
+            Piece piece = pieceFromFen(c);
+            if (piece == Piece::EMPTY || !IS_ON_BOARD(row, col))
+                return fail();
+            m_bitboards.put(piece, SQUARE(row, col));
+            col++;
+        }
+        if (col > 8)
+            return fail();
+    }
+    if (row != 7 || col != 8)
+        return fail();
+
+    StateInfo &state = m_states[0];
+
+    // side to move, castling and en passant default to white, none and none if they're missing
+    skipSpaces();
+    if (i < fen.size() && (fen[i] == 'w' || fen[i] == 'b'))
+    {
+        m_sideToMove = fen[i] == 'b' ? PlayerColor::Black : PlayerColor::White;
+        i++;
+    }
+
+    skipSpaces();
+    state.m_castling = 0;
+    for (; i < fen.size() && fen[i] != ' '; i++)
+    {
+        switch (fen[i])
+        {
+        case 'K': state.m_castling |= CastlingRights::WHITE_KINGSIDE; break;
+        case 'Q': state.m_castling |= CastlingRights::WHITE_QUEENSIDE; break;
+        case 'k': state.m_castling |= CastlingRights::BLACK_KINGSIDE; break;
+        case 'q': state.m_castling |= CastlingRights::BLACK_QUEENSIDE; break;
+        case '-': break;
+        default: return fail();
+        }
+    }
+
+    skipSpaces();
+    if (i + 1 < fen.size() && 'a' <= fen[i] && fen[i] <= 'h' && '1' <= fen[i + 1] && fen[i + 1] <= '8')
+    {
+        state.m_enPassant = static_cast<int8_t>(SQUARE('8' - fen[i + 1], fen[i] - 'a'));
+        i += 2;
+        // it has to be the square a pawn of the other side just skipped: on the sixth rank with white to move
+        // (the third with black), empty, with that pawn beyond it
+        const PlayerColor them = m_sideToMove == PlayerColor::White ? PlayerColor::Black : PlayerColor::White;
+        const int row = m_sideToMove == PlayerColor::White ? 2 : 5;
+        const int pawnSquare = state.m_enPassant + (m_sideToMove == PlayerColor::White ? 8 : -8);
+        if (ROW_OF(state.m_enPassant) != row || m_bitboards.at(state.m_enPassant) != Piece::EMPTY ||
+            m_bitboards.at(pawnSquare) != COLORED(Piece::WHITE_PAWN, them))
+        {
+            state.m_enPassant = -1;
+            return fail();
+        }
+    }
+    else if (i < fen.size() && fen[i] == '-')
+    {
+        i++;
+    }
+
+    // the clocks are only there if they're numbers: an EPD line has its operations here instead.
+    // larger numbers are held at these: reading more digits would overflow, and the halfmove clock has to fit in its
+    // 16 bits with room left for the game to go on
+    const int MAX_HALFMOVE_CLOCK = 10000;
+    const int MAX_FULLMOVE_NUMBER = 100000;
+    auto readNumber = [&](int &number) {
+        size_t start = i;
+        skipSpaces();
+        if (i >= fen.size() || fen[i] < '0' || '9' < fen[i])
+        {
+            i = start;
+            return false;
+        }
+        number = 0;
+        for (; i < fen.size() && '0' <= fen[i] && fen[i] <= '9'; i++)
+            number = std::min(number * 10 + (fen[i] - '0'), MAX_FULLMOVE_NUMBER);
+        return true;
+    };
+    int halfmoveClock = 0;
+    int fullmoveNumber = 1;
+    if (readNumber(halfmoveClock))
+    {
+        state.m_halfmoveClock = static_cast<uint16_t>(std::min(halfmoveClock, MAX_HALFMOVE_CLOCK));
+        if (readNumber(fullmoveNumber))
+            m_startPly = 2 * (std::max(fullmoveNumber, 1) - 1) + (m_sideToMove == PlayerColor::Black ? 1 : 0);
+    }
+    if (m_startPly == 0 && m_sideToMove == PlayerColor::Black)
+        m_startPly = 1;
+
+    if (end)
+        *end = i;
+    refreshState();
+    return true;
+}
+
+std::string Board::getFen() const
+{
+    std::string fen;
+    fen.reserve(90);
+    for (int row = 0; row < 8; row++)
+    {
+        int empty = 0;
+        for (int col = 0; col < 8; col++)
+        {
+            Piece piece = m_bitboards.at(SQUARE(row, col));
+            if (piece == Piece::EMPTY)
+            {
+                empty++;
+                continue;
+            }
+            if (empty)
+                fen += static_cast<char>('0' + empty);
+            empty = 0;
+            fen += fenPieces[piece];
+        }
+        if (empty)
+            fen += static_cast<char>('0' + empty);
+        if (row < 7)
+            fen += '/';
+    }
+
+    fen += m_sideToMove == PlayerColor::Black ? " b " : " w ";
+
+    uint8_t rights = getCastlingRights();
+    if (rights & CastlingRights::WHITE_KINGSIDE) fen += 'K';
+    if (rights & CastlingRights::WHITE_QUEENSIDE) fen += 'Q';
+    if (rights & CastlingRights::BLACK_KINGSIDE) fen += 'k';
+    if (rights & CastlingRights::BLACK_QUEENSIDE) fen += 'q';
+    if (!rights) fen += '-';
+
+    int enPassant = getEnPassantSquare();
+    fen += ' ';
+    if (enPassant >= 0)
+    {
+        fen += static_cast<char>('a' + COL_OF(enPassant));
+        fen += static_cast<char>('8' - ROW_OF(enPassant));
+    }
+    else
+    {
+        fen += '-';
+    }
+
+    fen += ' ' + std::to_string(getHalfmoveClock()) + ' ' + std::to_string(getFullmoveNumber());
+    return fen;
+}
@@ -4,13 +4,50 @@
 #include "Move.h"
 #include "PlayerColor.h"
 #include "Piece.h"
+#include "Bitboard.h"
+#include "Psqt.h"
+#include "Nnue.h"
 
 #include <vector>
 #include <iostream>
 #include <algorithm>
+#include <string>
+#include <string_view>
 
 #define DEFAULT_SELECTION {{0,0},false}
 
+enum CastlingRights : uint8_t
+{
+    WHITE_KINGSIDE = 1,
+    WHITE_QUEENSIDE = 2,
+    BLACK_KINGSIDE = 4,
+    BLACK_QUEENSIDE = 8,
+    ALL_CASTLING = 15
+};
+
+// everything about a position that a move can't be undone from: one per ply, pushed by move() and popped by undo()
+struct StateInfo
+{
+    Move m_move;                                             // the move that led here (null for the starting position)
+    Piece m_captured{Piece::EMPTY};                          // what that move took
+    uint8_t m_castling{CastlingRights::ALL_CASTLING};        // CastlingRights still available
+    int8_t m_enPassant{-1};                                  // square a pawn can be taken on in passing, or -1
+    uint16_t m_halfmoveClock{0};                             // plies since the last capture or pawn move
+    uint16_t m_pliesFromNull{0};                             // plies since the last null move (or the start)
+    int16_t m_repetition{0};                                 // plies back to the same position, negative if that was
+                                                             // a repeat too, 0 if it hasn't come up before
+    uint64_t m_hash{0};
+    nnue::DirtyPieces m_dirty;                               // the pieces that move took off / put on the board
+};
+
+// which moves to generate: the search looks at captures and quiet moves separately
+enum class MoveType
+{
+    All,
+    Captures, // captures and promotions
+    Quiets,   // everything else
+};
+
 struct Selection
 {
     std::pair<int,int> m_selection;
@@ -21,15 +58,80 @@ class Board
 {
 public:
     PlayerColor getColor(int row, int col);
-    const std::vector<Move> &getValidMoves() const { return m_availableMoves; }
+    const MoveList &getValidMoves() const { return m_availableMoves; }
+    // the legal moves of the piece on the square, taken from legalMoves()
     void setValidMoves(std::pair<int, int> position);
+    /// @brief every legal move for the player to move, generated the first time it's asked for in a position and
+    /// kept until the next move(), undo() or setup. for the client's clicks and game status checks, the search
+    /// generates its own
+    const MoveList &legalMoves();
+    // appends every legal move for the player to move
+    void getLegalMoves(MoveList &moves);
+    // appends only the legal captures and promotions (for quiescence search), without generating the rest
+    void getLegalCaptures(MoveList &moves);
+    // appends the rest: legal moves that neither capture nor promote
+    void getLegalQuiets(MoveList &moves);
+    // appends the legal moves of the pieces on the given squares only, e.g. of one kind of piece
+    void getLegalMovesFrom(MoveList &moves, Bitboard from);
+    // whether the move is legal here, e.g. a move from the transposition table that may belong to another position
+    bool isLegal(Move move);
+    // every piece of either colour attacking the square, with sliders blocked by the given occupancy
+    Bitboard attackersTo(int square, Bitboard occupied) const;
     const PlayerColor getPlayerToMove() const;
+    // the square a pawn can be taken on in passing, or -1
+    int getEnPassantSquare() const { return m_states.back().m_enPassant; }
+    // CastlingRights still available to both players
+    uint8_t getCastlingRights() const { return m_states.back().m_castling; }
+    // plies since the last capture or pawn move (the fifty move rule counts to 100)
+    int getHalfmoveClock() const { return m_states.back().m_halfmoveClock; }
+    // the position has been on the board twice before, since the last capture or pawn move
+    bool isThreefoldRepetition() const { return m_states.back().m_repetition < 0; }
+    // a hundred plies without a capture or pawn move, unless the last of them mated
+    bool isFiftyMoveDraw();
+    /// @brief a draw to a search whose root is ply plies up: the fifty move rule, a threefold repetition, or any
+    /// repetition of a position since the root (whoever could have avoided it, would have)
+    bool isDraw(int ply);
+    /// @brief whether the side to move has a move back to a position from earlier on (since the last capture, pawn
+    /// move or null move), so it can hold a draw at least. a lookup in cuckoo::table per earlier position, without
+    /// generating any moves
+    bool hasUpcomingRepetition(int ply) const;
+    // starts at 1 and goes up after each black move
+    int getFullmoveNumber() const { return 1 + (m_startPly + static_cast<int>(m_states.size()) - 1) / 2; }
+
+    /// @brief replaces the position with a FEN one, reusing the board's memory (so loading many positions doesn't allocate).
+    /// the clocks are optional, as in EPD. on an invalid FEN the board is left empty and false is returned.
+    /// @param end if given, set to the index just past the last field read (where an EPD line's operations start)
+    bool setFen(std::string_view fen, size_t *end = nullptr);
+    // the position as a FEN string, clocks included
+    std::string getFen() const;
+    // 64-bit zobrist key of the position, kept up to date by move() and undo()
+    uint64_t getHash() const { return m_hash; }
+    // the same key rebuilt from scratch, to check the incremental one against
+    uint64_t computeHash() const;
+    // zobrist key of the pawns alone, for the pawn structure cache (eval::PawnTable). kept up to date like the hash
+    uint64_t getPawnHash() const { return m_pawnHash; }
+    uint64_t computePawnHash() const;
+    // sum of eval::psq over every piece (material and placement, white's point of view), kept up to date like the hash
+    eval::Score getPsq() const { return m_psq; }
+    // game phase from the pieces left, 0 (pawn endgame) up to eval::PHASE_MAX, or beyond it with extra promoted pieces
+    int getPhase() const { return m_phase; }
+    eval::Score computePsq() const;
+    /// @brief the network's first layer for this position, brought up to date from the moves made since it was last
+    /// asked for (or from scratch where that's not possible). only valid with a network loaded, see nnue::load.
+    const nnue::Accumulator &getAccumulator() const;
     void move(Move move);
+    // passes the turn without moving (null move pruning). undone by undo()
+    void makeNullMove();
     void undo();
-    const std::vector<std::vector<Piece>> &getBoard() { return m_board; }
+    // compatibility view of the bitboards as the old 8x8 grid
+    const std::vector<std::vector<Piece>> &getBoard();
+    const Bitboards &getBitboards() const { return m_bitboards; }
     bool isInCheck(PlayerColor playerToMove);
     bool canKingMove(PlayerColor color);
+    // whether winner has mated the player to move (from the cached legal moves)
     bool isCheckmate(PlayerColor winner);
+    // the player to move has no legal moves but isn't in check
+    bool isStalemate();
 
     Selection m_selection = DEFAULT_SELECTION;
 
@@ -50,9 +152,10 @@ public:
                   << std::endl;
         for (int row = 0; row < 8; row++)
         {
-            for (auto &letter : m_board[row])
+            for (int col = 0; col < 8; col++)
             {
-                std::cout << getChar(letter) << " ";
+                Piece piece = m_bitboards.at(SQUARE(row, col));
+                std::cout << getChar(piece) << " ";
             }
             std::cout << " " << row + 1 << std::endl;
         }
@@ -60,71 +163,95 @@ public:
 
     Board()
     {
+        const Piece backRank[8] = {Piece::BLACK_ROOK, Piece::BLACK_KNIGHT, Piece::BLACK_BISHOP, Piece::BLACK_QUEEN,
+                                   Piece::BLACK_KING, Piece::BLACK_BISHOP, Piece::BLACK_KNIGHT, Piece::BLACK_ROOK};
 
-        m_board[0][0] = Piece::BLACK_ROOK;
-        m_board[0][1] = Piece::BLACK_KNIGHT;
-        m_board[0][2] = Piece::BLACK_BISHOP;
-        m_board[0][3] = Piece::BLACK_QUEEN;
-        m_board[0][4] = Piece::BLACK_KING;
-        m_board[0][5] = Piece::BLACK_BISHOP;
-        m_board[0][6] = Piece::BLACK_KNIGHT;
-        m_board[0][7] = Piece::BLACK_ROOK;
-
-        for (auto &piece : m_board[1])
-        {
-            piece = Piece::BLACK_PAWN;
-        }
-
-        for (auto &piece : m_board[6])
+        for (int col = 0; col < 8; col++)
         {
-            piece = Piece::WHITE_PAWN;
+            m_bitboards.put(backRank[col], SQUARE(0, col));
+            m_bitboards.put(Piece::BLACK_PAWN, SQUARE(1, col));
+            m_bitboards.put(Piece::WHITE_PAWN, SQUARE(6, col));
+            // white pieces are the black ones shifted down by 6 in the enum
+            m_bitboards.put(static_cast<Piece>(backRank[col] - 6), SQUARE(7, col));
         }
-
-        m_board[7][0] = Piece::WHITE_ROOK;
-        m_board[7][1] = Piece::WHITE_KNIGHT;
-        m_board[7][2] = Piece::WHITE_BISHOP;
-        m_board[7][3] = Piece::WHITE_QUEEN;
-        m_board[7][4] = Piece::WHITE_KING;
-        m_board[7][5] = Piece::WHITE_BISHOP;
-        m_board[7][6] = Piece::WHITE_KNIGHT;
-        m_board[7][7] = Piece::WHITE_ROOK;
+        refreshState();
     }
 
     Board(std::vector<std::vector<Piece>> pieces)
     {
-        this->m_board = pieces;
+        for (int row = 0; row < 8; row++)
+        {
+            for (int col = 0; col < 8; col++)
+            {
+                if (pieces[row][col] != Piece::EMPTY)
+                    m_bitboards.put(pieces[row][col], SQUARE(row, col));
+            }
+        }
+        refreshState();
     }
 
+    // the position of a FEN string, see setFen
+    explicit Board(const std::string &fen);
+
     Board(const Board &b)
     {
         // copy all fields
-        for (auto move : b.m_previousMoves)
-        {
-            m_previousMoves.push_back(move);
-        }
-        this->m_board = b.m_board;
+        this->m_states = b.m_states;
+        this->m_bitboards = b.m_bitboards;
+        this->m_sideToMove = b.m_sideToMove;
+        this->m_startPly = b.m_startPly;
+        this->m_hash = b.m_hash;
+        this->m_pawnHash = b.m_pawnHash;
+        this->m_psq = b.m_psq;
+        this->m_phase = b.m_phase;
     }
 
 private:
-    void addRookMoves(std::vector<Move> &moves, const PlayerColor &playerToMove, const std::pair<int, int> &position);
-    void addBishopMoves(std::vector<Move> &moves, const PlayerColor &playerToMove, const std::pair<int, int> &position);
-    void addPawnMoves(std::vector<Move> &moves, const PlayerColor &playerToMove, const std::pair<int, int> &position);
-    void addKnightMoves(std::vector<Move> &moves, const PlayerColor &playerToMove, const std::pair<int, int> &position);
-    void addKingMoves(std::vector<Move> &moves, const PlayerColor &playerToMove, const std::pair<int, int> &position);
-    void getMoves(std::vector<Move> &moves, const PlayerColor playerToMove, std::pair<int, int> position, bool includeKing);
-
-    // consider refactoring to shared data structure for moves under attack 
-    // since it's a common and expensive operation
+    void addAttackMoves(MoveList &moves, const PlayerColor &playerToMove, int from, Bitboard targets);
+    void addPawnMove(MoveList &moves, int from, int to);
+    void addPawnMoves(MoveList &moves, const PlayerColor &playerToMove, int from, Bitboard legalMask, bool enPassant);
+    void addKingMoves(MoveList &moves, const PlayerColor &playerToMove, int from, MoveType type);
+    // the legal moves of the given type, for the pieces on fromMask
+    void generateLegalMoves(MoveList &moves, MoveType type, Bitboard fromMask = ~static_cast<Bitboard>(0));
     bool isUnderAttack(PlayerColor playerUnderAttack, std::pair<int,int> square);
 
-    // Piece m_board[8][8]{Piece::EMPTY};
-    std::vector<std::vector<Piece>> m_board = std::vector<std::vector<Piece>>(
-        8, std::vector<Piece>(8, Piece::EMPTY));
-    std::vector<Move> m_previousMoves;
+    // the only places pieces are added to / taken off the bitboards once the position is set up,
+    // so everything derived from the pieces (the hash, the evaluation sums) is updated in one spot
+    void putPiece(Piece piece, int square);
+    void removePiece(int square);
+    // works out everything derived from the pieces from scratch, after setting up a position directly on the bitboards
+    void refreshState();
+    uint64_t enPassantKey() const;
+    // fills in the new state's m_repetition, from the earlier ones
+    void findRepetition();
+    // marks the accumulator for the ply just pushed as stale, it may hold one from a line that was undone
+    void invalidateAccumulator();
+
+    Bitboards m_bitboards;
+    PlayerColor m_sideToMove{PlayerColor::White};
+    // plies played in the game before the starting position (from the FEN's fullmove number)
+    int m_startPly{0};
+    uint64_t m_hash{0};
+    uint64_t m_pawnHash{0};
+    eval::Score m_psq;
+    int m_phase{0};
+    // rebuilt from m_bitboards by getBoard(), never read internally
+    std::vector<std::vector<Piece>> m_boardView;
+    // the starting position's state, then one per move played. a grid can't say whether the kings or rooks
+    // have moved, so the starting state assumes they haven't
+    std::vector<StateInfo> m_states = std::vector<StateInfo>(1);
+    // one per entry of m_states, filled in lazily by getAccumulator (and only ever with a network loaded).
+    // copies of the board start without any
+    mutable std::vector<nnue::Accumulator> m_accumulators;
+    // the nnue::generation they were computed with
+    mutable uint32_t m_accumulatorGeneration{0};
     // instead (in addition to?) of a vector of previous moves, we should use a map with each piece.
     // ordered map !!!
     // ordered_map<Piece,std::vector<Moves>>
     // or just
     // std::vector<Move>[16]
-    std::vector<Move> m_availableMoves;
+    MoveList m_availableMoves;
+    // see legalMoves(). a copy of the board starts without them
+    MoveList m_legalMoves;
+    bool m_legalMovesValid{false};
 };
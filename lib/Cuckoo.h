@@ -0,0 +1,94 @@
+// # Copyright (c) Dylan Leclair
+#pragma once
+
+#include "Attacks.h"
+#include "Zobrist.h"
+
+#include <array>
+#include <cstdint>
+
+// every reversible move (a piece other than a pawn going from one square to another and back, on an empty board)
+// by the hash change it makes, so "is there a move from this position to that one" is one or two lookups.
+// a cuckoo hash: each key has two possible slots and inserting one pushes whatever was there to its other slot.
+// worked out at compile time, like the attack tables
+namespace cuckoo
+{
+    constexpr int SIZE = 8192;
+
+    constexpr int h1(uint64_t key) { return static_cast<int>(key & (SIZE - 1)); }
+    constexpr int h2(uint64_t key) { return static_cast<int>((key >> 16) & (SIZE - 1)); }
+
+    struct Table
+    {
+        std::array<uint64_t, SIZE> m_keys{};
+        // start | dest << 6, with start < dest. 0 for an empty slot
+        std::array<uint16_t, SIZE> m_moves{};
+        int m_count{0};
+    };
+
+    namespace detail
+    {
+        // whether the piece goes between the squares on an empty board
+        constexpr bool reaches(Piece piece, int a, int b)
+        {
+            const bool straight = ROW_OF(a) == ROW_OF(b) || COL_OF(a) == COL_OF(b);
+            switch (piece)
+            {
+            case Piece::WHITE_KNIGHT:
+            case Piece::BLACK_KNIGHT:
+                return attacks::knightAttacks[a] & SQUARE_BB(b);
+            case Piece::WHITE_KING:
+            case Piece::BLACK_KING:
+                return attacks::kingAttacks[a] & SQUARE_BB(b);
+            case Piece::WHITE_ROOK:
+            case Piece::BLACK_ROOK:
+                return attacks::detail::aligned(a, b) && straight;
+            case Piece::WHITE_BISHOP:
+            case Piece::BLACK_BISHOP:
+                return attacks::detail::aligned(a, b) && !straight;
+            case Piece::WHITE_QUEEN:
+            case Piece::BLACK_QUEEN:
+                return attacks::detail::aligned(a, b);
+            default:
+                return false;
+            }
+        }
+
+        constexpr Table generate()
+        {
+            Table table{};
+            for (int piece = Piece::WHITE_PAWN; piece <= Piece::BLACK_KING; piece++)
+            {
+                for (int a = 0; a < 64; a++)
+                {
+                    for (int b = a + 1; b < 64; b++)
+                    {
+                        if (!reaches(static_cast<Piece>(piece), a, b))
+                            continue;
+                        uint64_t key = zobrist::keys.m_pieces[piece - 1][a] ^ zobrist::keys.m_pieces[piece - 1][b] ^ zobrist::keys.m_sideToMove;
+                        uint16_t move = static_cast<uint16_t>(a | b << 6);
+                        int slot = h1(key);
+                        while (true)
+                        {
+                            const uint64_t displacedKey = table.m_keys[slot];
+                            const uint16_t displacedMove = table.m_moves[slot];
+                            table.m_keys[slot] = key;
+                            table.m_moves[slot] = move;
+                            if (displacedMove == 0)
+                                break;
+                            // the one pushed out goes to its other slot
+                            key = displacedKey;
+                            move = displacedMove;
+                            slot = slot == h1(key) ? h2(key) : h1(key);
+                        }
+                        table.m_count++;
+                    }
+                }
+            }
+            return table;
+        }
+    }
+
+    inline constexpr Table table = detail::generate();
+    static_assert(table.m_count == 3668, "every reversible move has its slot");
+}
@@ -0,0 +1,80 @@
+// # Copyright (c) Dylan Leclair
+#include "Epd.h"
+
+#include <cstring>
+
+static const size_t BLOCK_SIZE = 1 << 20;
+
+EpdReader::EpdReader(const std::string &path)
+    : m_file(std::fopen(path.c_str(), "rb")),
+      m_buffer(BLOCK_SIZE)
+{
+}
+
+EpdReader::~EpdReader()
+{
+    if (m_file)
+        std::fclose(m_file);
+}
+
+bool EpdReader::readLine(std::string_view &line)
+{
+    while (true)
+    {
+        const char *begin = m_buffer.data() + m_begin;
+        const char *newline = static_cast<const char *>(std::memchr(begin, '\n', m_end - m_begin));
+        if (newline)
+        {
+            line = std::string_view(begin, newline - begin);
+            m_begin += line.size() + 1;
+            break;
+        }
+        if (m_eof || !m_file)
+        {
+            // the last line might not end in a newline
+            if (m_begin == m_end)
+                return false;
+            line = std::string_view(begin, m_end - m_begin);
+            m_begin = m_end;
+            break;
+        }
+
+        // move the partial line to the front and fill up the rest. a line longer than the whole buffer grows it
+        std::memmove(m_buffer.data(), begin, m_end - m_begin);
+        m_end -= m_begin;
+        m_begin = 0;
+        if (m_end == m_buffer.size())
+            m_buffer.resize(m_buffer.size() * 2);
+        size_t read = std::fread(m_buffer.data() + m_end, 1, m_buffer.size() - m_end, m_file);
+        m_end += read;
+        m_eof = read == 0;
+    }
+
+    if (!line.empty() && line.back() == '\r')
+        line.remove_suffix(1);
+    m_lineNumber++;
+    return true;
+}
+
+bool EpdReader::next(Board &board)
+{
+    std::string_view line;
+    while (readLine(line))
+    {
+        size_t start = line.find_first_not_of(" \t");
+        if (start == std::string_view::npos || line[start] == '#')
+            continue;
+
+        size_t end = 0;
+        if (!board.setFen(line, &end))
+        {
+            m_invalidLines++;
+            continue;
+        }
+        m_operations = line.substr(end);
+        size_t operations = m_operations.find_first_not_of(" \t");
+        m_operations.remove_prefix(operations == std::string_view::npos ? m_operations.size() : operations);
+        return true;
+    }
+    return false;
+}
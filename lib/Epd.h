@@ -0,0 +1,50 @@
+// # Copyright (c) Dylan Leclair
+#pragma once
+
+#include "Board.h"
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// @brief streams the positions of an EPD (or one-FEN-per-line) file into a board, one line at a time.
+/// the file is read in large blocks and every line is parsed where it lies in the buffer,
+/// so after the first block nothing is allocated no matter how many positions the file holds.
+/// blank lines and lines starting with '#' are skipped.
+class EpdReader
+{
+public:
+    explicit EpdReader(const std::string &path);
+    ~EpdReader();
+
+    EpdReader(const EpdReader &) = delete;
+    EpdReader &operator=(const EpdReader &) = delete;
+
+    bool isOpen() const { return m_file != nullptr; }
+
+    /// @brief loads the next valid position into the board. invalid lines are counted and skipped.
+    /// @return false once the file is exhausted
+    bool next(Board &board);
+
+    /// @brief what follows the position on the current line (e.g. "bm e4; id \"x\";" or ";D1 20 ;D2 400").
+    /// only valid until the next call to next().
+    std::string_view operations() const { return m_operations; }
+
+    size_t lineNumber() const { return m_lineNumber; }
+    size_t invalidLines() const { return m_invalidLines; }
+
+private:
+    // the next line of the file without its newline, false at the end of the file
+    bool readLine(std::string_view &line);
+
+    std::FILE *m_file{nullptr};
+    std::vector<char> m_buffer;
+    size_t m_begin{0}; // unread part of the buffer is [m_begin, m_end)
+    size_t m_end{0};
+    bool m_eof{false};
+
+    std::string_view m_operations;
+    size_t m_lineNumber{0};
+    size_t m_invalidLines{0};
+};
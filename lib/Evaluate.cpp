@@ -0,0 +1,156 @@
+// # Copyright (c) Dylan Leclair
+#include "Evaluate.h"
+#include "Attacks.h"
+#include "Nnue.h"
+
+#include <algorithm>
+
+namespace eval
+{
+    const int pieceValues[15] = {
+        0,
+        100, 500, 320, 330, 900, 0, // white pawn, rook, knight, bishop, queen, king
+        100, 500, 320, 330, 900, 0, // black
+        0, 0};
+
+    // the side to move is worth a little: it gets to act first
+    static const int TEMPO = 10;
+    static const Score BISHOP_PAIR{30, 50};
+    // endgame, per row a passed pawn has come: the kings' distances to the square in front of it
+    static const int PASSED_THEIR_KING = 5;
+    static const int PASSED_OUR_KING = 2;
+
+    // the parts of the pawn terms that depend on where the kings are, so can't be kept in the pawn table
+    static Score kingTerms(const Bitboards &bitboards, const PawnEntry &entry, PlayerColor us)
+    {
+        const PlayerColor them = us == PlayerColor::White ? PlayerColor::Black : PlayerColor::White;
+        const Bitboard ourKings = bitboards.pieces(static_cast<Piece>(Piece::WHITE_KING + 6 * us));
+        const Bitboard theirKings = bitboards.pieces(static_cast<Piece>(Piece::WHITE_KING + 6 * them));
+        Score score;
+        // a position set up without a king (setFen allows it) has no king to shelter or to race
+        if (!ourKings || !theirKings)
+            return score;
+        const int ourKing = bitboard::lsb(ourKings);
+        const int theirKing = bitboard::lsb(theirKings);
+
+        // the shield only counts while the king is still at home behind it
+        const int kingRow = us == PlayerColor::White ? 7 - ROW_OF(ourKing) : ROW_OF(ourKing);
+        if (kingRow <= 1)
+            score.m_mg += entry.m_shield[us][COL_OF(ourKing)];
+
+        Bitboard passed = entry.m_passed[us];
+        while (passed)
+        {
+            const int square = bitboard::popLsb(passed);
+            const int row = us == PlayerColor::White ? 7 - ROW_OF(square) : ROW_OF(square);
+            const int stop = square + (us == PlayerColor::White ? -8 : 8);
+            if (row < 2 || row > 6)
+                continue;
+            score.m_eg += (PASSED_THEIR_KING * attacks::distance[theirKing][stop] - PASSED_OUR_KING * attacks::distance[ourKing][stop]) * (row - 1);
+        }
+        return score;
+    }
+
+    int evaluate(const Board &board, PawnTable *pawns)
+    {
+        if (nnue::isLoaded())
+            return nnue::evaluate(board);
+
+        const Bitboards &bitboards = board.getBitboards();
+
+        Score score = board.getPsq();
+
+        PawnEntry computed;
+        if (!pawns)
+            computed = evaluatePawns(bitboards.pieces(Piece::WHITE_PAWN), bitboards.pieces(Piece::BLACK_PAWN));
+        const PawnEntry &entry = pawns ? pawns->probe(board) : computed;
+        score += entry.m_score;
+        score += kingTerms(bitboards, entry, PlayerColor::White);
+        score -= kingTerms(bitboards, entry, PlayerColor::Black);
+
+        if (bitboard::popCount(bitboards.pieces(Piece::WHITE_BISHOP)) >= 2)
+            score += BISHOP_PAIR;
+        if (bitboard::popCount(bitboards.pieces(Piece::BLACK_BISHOP)) >= 2)
+            score -= BISHOP_PAIR;
+
+        // promotions can push the phase past the maximum
+        int phase = std::min(board.getPhase(), PHASE_MAX);
+        int blended = (score.m_mg * phase + score.m_eg * (PHASE_MAX - phase)) / PHASE_MAX;
+        return (board.getPlayerToMove() == PlayerColor::White ? blended : -blended) + TEMPO;
+    }
+
+    int see(const Board &board, Move move)
+    {
+        if (move.isCastling())
+            return 0;
+
+        // a king can only take last: anything taking it back would be worth more than the rest of the exchange
+        auto value = [](Piece piece) { return piece == Piece::WHITE_KING || piece == Piece::BLACK_KING ? 20000 : pieceValues[piece]; };
+
+        const Bitboards &bitboards = board.getBitboards();
+        const int to = move.dest();
+        Bitboard occupied = bitboards.occupied();
+        Bitboard from = SQUARE_BB(move.start());
+        Piece attacker = bitboards.at(move.start());
+        PlayerColor side = getPieceColor(attacker);
+
+        // gain[i] is what the side making the i-th capture has won so far, if the exchange stops there
+        int gain[32];
+        int depth = 0;
+        gain[0] = value(bitboards.at(to));
+        if (move.isEnPassant())
+        {
+            gain[0] = pieceValues[Piece::WHITE_PAWN];
+            occupied ^= SQUARE_BB(SQUARE(ROW_OF(move.start()), COL_OF(to)));
+        }
+        if (move.isPromotion())
+        {
+            attacker = move.promotion();
+            gain[0] += pieceValues[attacker] - pieceValues[Piece::WHITE_PAWN];
+        }
+
+        const Bitboard rooks = bitboards.pieces(Piece::WHITE_ROOK) | bitboards.pieces(Piece::BLACK_ROOK) |
+                               bitboards.pieces(Piece::WHITE_QUEEN) | bitboards.pieces(Piece::BLACK_QUEEN);
+        const Bitboard bishops = bitboards.pieces(Piece::WHITE_BISHOP) | bitboards.pieces(Piece::BLACK_BISHOP) |
+                                 bitboards.pieces(Piece::WHITE_QUEEN) | bitboards.pieces(Piece::BLACK_QUEEN);
+        Bitboard attackers = board.attackersTo(to, occupied);
+        do
+        {
+            // what the other side would have if it took the piece now on the square
+            // (if nothing can, this last entry is never used)
+            depth++;
+            gain[depth] = value(attacker) - gain[depth - 1];
+
+            // the piece that just took is out of the way, so sliders behind it see the square
+            occupied ^= from;
+            attackers = (attackers | (attacks::rookAttacks(to, occupied) & rooks) | (attacks::bishopAttacks(to, occupied) & bishops)) & occupied;
+            side = side == PlayerColor::White ? PlayerColor::Black : PlayerColor::White;
+
+            from = 0;
+            for (Piece piece : {Piece::WHITE_PAWN, Piece::WHITE_KNIGHT, Piece::WHITE_BISHOP, Piece::WHITE_ROOK, Piece::WHITE_QUEEN, Piece::WHITE_KING})
+            {
+                Bitboard candidates = attackers & bitboards.pieces(static_cast<Piece>(piece + 6 * side));
+                if (candidates)
+                {
+                    from = candidates & (~candidates + 1);
+                    attacker = piece;
+                    break;
+                }
+            }
+        } while (from);
+
+        // back up the exchange: each side only takes if that's better than stopping
+        while (--depth)
+            gain[depth - 1] = -std::max(-gain[depth - 1], gain[depth]);
+        return gain[0];
+    }
+
+    bool hasNonPawnMaterial(const Board &board)
+    {
+        const Bitboards &bitboards = board.getBitboards();
+        PlayerColor us = board.getPlayerToMove();
+        Bitboard pawnsAndKing = bitboards.pieces(static_cast<Piece>(Piece::WHITE_PAWN + 6 * us)) |
+                                bitboards.pieces(static_cast<Piece>(Piece::WHITE_KING + 6 * us));
+        return (bitboards.m_occupancy[us] & ~pawnsAndKing) != 0;
+    }
+}
@@ -0,0 +1,27 @@
+// # Copyright (c) Dylan Leclair
+#pragma once
+
+#include "Board.h"
+#include "Pawns.h"
+#include "Psqt.h"
+
+namespace eval
+{
+    // centipawns, indexed by Piece (EMPTY and the square markers are worth nothing)
+    extern const int pieceValues[15];
+
+    /// @brief static evaluation of the position in centipawns, from the side to move's point of view.
+    /// material and piece placement come from the sums the board keeps up to date, blended between
+    /// middlegame and endgame by the game phase; only the few terms that aren't incremental are worked out here.
+    /// the pawn structure comes from the table when one is given, and is worked out from scratch otherwise.
+    /// with a network loaded (nnue::load) the network evaluates instead.
+    int evaluate(const Board &board, PawnTable *pawns = nullptr);
+
+    /// @brief static exchange evaluation: the material the side to move ends up with (in pieceValues) if the move is
+    /// played and both sides then keep taking back on its destination square, least valuable piece first, for as long
+    /// as it pays. pins and checks are ignored. negative means the move loses material.
+    int see(const Board &board, Move move);
+
+    /// @brief whether the side to move has anything besides pawns and king (null move is unsafe in pawn endings).
+    bool hasNonPawnMaterial(const Board &board);
+}
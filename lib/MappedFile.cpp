@@ -0,0 +1,74 @@
+// # Copyright (c) Dylan Leclair
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const std::string &path, bool sequential)
+{
+    close();
+#ifdef _WIN32
+    (void)sequential;
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file)
+        return false;
+    size_t size = static_cast<size_t>(file.tellg());
+    if (size == 0)
+        return false;
+    char *data = new char[size];
+    file.seekg(0);
+    if (!file.read(data, size))
+    {
+        delete[] data;
+        return false;
+    }
+    m_data = data;
+    m_size = size;
+    return true;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0)
+    {
+        ::close(fd);
+        return false;
+    }
+    size_t size = static_cast<size_t>(info.st_size);
+    void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping stays valid after the descriptor is closed
+    ::close(fd);
+    if (data == MAP_FAILED)
+        return false;
+    if (sequential)
+        madvise(data, size, MADV_SEQUENTIAL);
+    m_data = static_cast<const char *>(data);
+    m_size = size;
+    return true;
+#endif
+}
+
+void MappedFile::close()
+{
+    if (!m_data)
+        return;
+#ifdef _WIN32
+    delete[] m_data;
+#else
+    munmap(const_cast<char *>(m_data), m_size);
+#endif
+    m_data = nullptr;
+    m_size = 0;
+}
@@ -0,0 +1,31 @@
+// # Copyright (c) Dylan Leclair
+#pragma once
+
+#include <string>
+#include <string_view>
+
+/// @brief a whole file in memory, read only: mapped where there's mmap (pages are only read from disk as they're
+/// touched, and shared with the page cache), read in otherwise.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    /// @brief maps the file, replacing whatever was mapped before. false if it can't be opened or is empty.
+    /// a file that will be read front to back should say so, the kernel then reads ahead further.
+    bool open(const std::string &path, bool sequential = false);
+    void close();
+
+    bool isOpen() const { return m_data != nullptr; }
+    const char *data() const { return m_data; }
+    size_t size() const { return m_size; }
+    std::string_view view() const { return {m_data, m_size}; }
+
+private:
+    const char *m_data{nullptr};
+    size_t m_size{0};
+};
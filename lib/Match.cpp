@@ -0,0 +1,267 @@
+// # Copyright (c) Dylan Leclair
+#include "Match.h"
+#include "Pgn.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+namespace match
+{
+    namespace
+    {
+        const char *START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+        // the chance of scoring a point against someone this much weaker (in Elo)
+        double expectedScore(double elo)
+        {
+            return 1 / (1 + std::pow(10, -elo / 400));
+        }
+
+        // the variance of a single game's points
+        double variance(const Score &score)
+        {
+            const double r = score.ratio();
+            return (score.m_wins * (1 - r) * (1 - r) + score.m_draws * (0.5 - r) * (0.5 - r) + score.m_losses * r * r) /
+                   std::max(score.games(), 1);
+        }
+
+        // neither side can ever mate: bare kings, or one knight or bishop between them
+        bool isInsufficientMaterial(const Bitboards &bitboards)
+        {
+            Bitboard minors = 0;
+            for (Piece piece : {Piece::WHITE_PAWN, Piece::WHITE_ROOK, Piece::WHITE_QUEEN, Piece::BLACK_PAWN, Piece::BLACK_ROOK, Piece::BLACK_QUEEN})
+            {
+                if (bitboards.pieces(piece))
+                    return false;
+            }
+            for (Piece piece : {Piece::WHITE_KNIGHT, Piece::WHITE_BISHOP, Piece::BLACK_KNIGHT, Piece::BLACK_BISHOP})
+                minors |= bitboards.pieces(piece);
+            return bitboard::popCount(minors) <= 1;
+        }
+    }
+
+    bool parseEngine(const std::string &spec, EngineConfig &config)
+    {
+        config = EngineConfig();
+        bool limited = false;
+        std::stringstream fields(spec);
+        std::string field;
+        while (std::getline(fields, field, ','))
+        {
+            size_t equals = field.find('=');
+            if (equals == std::string::npos)
+            {
+                std::cout << "Error at parseEngine: expected key=value, got \"" << field << "\"" << std::endl;
+                return false;
+            }
+            const std::string key = field.substr(0, equals);
+            const std::string value = field.substr(equals + 1);
+            if (key == "name")
+                config.m_name = value;
+            else if (key == "depth")
+                config.m_limits.m_depth = std::clamp(std::atoi(value.c_str()), 1, search::MAX_PLY);
+            else if (key == "nodes")
+                config.m_limits.m_nodes = std::strtoull(value.c_str(), nullptr, 10);
+            else if (key == "movetime")
+                config.m_limits.m_timeMs = std::atoi(value.c_str());
+            else if (key == "hash")
+                config.m_hashMb = std::max<size_t>(1, std::strtoull(value.c_str(), nullptr, 10));
+            else if (key == "tc")
+            {
+                // seconds, "base+increment" or just "base"
+                size_t plus = value.find('+');
+                config.m_clockMs = static_cast<int>(std::atof(value.substr(0, plus).c_str()) * 1000);
+                if (plus != std::string::npos)
+                    config.m_incrementMs = static_cast<int>(std::atof(value.substr(plus + 1).c_str()) * 1000);
+            }
+            else
+            {
+                std::cout << "Error at parseEngine: unknown key \"" << key << "\"" << std::endl;
+                return false;
+            }
+            limited |= key == "depth" || key == "nodes" || key == "movetime" || key == "tc";
+        }
+        if (!limited)
+        {
+            std::cout << "Error at parseEngine: \"" << spec << "\" needs a depth, nodes, movetime or tc" << std::endl;
+            return false;
+        }
+        if (config.m_name.empty())
+            config.m_name = spec;
+        return true;
+    }
+
+    GameRecord playGame(const std::string &fen, const EngineConfig &white, const EngineConfig &black,
+                        search::ThreadedSearch &whiteSearch, search::ThreadedSearch &blackSearch,
+                        const Adjudication &adjudication)
+    {
+        GameRecord game;
+        game.m_startFen = fen;
+        Board board(fen);
+        whiteSearch.table().clear();
+        blackSearch.table().clear();
+
+        const EngineConfig *configs[2] = {&white, &black};
+        search::ThreadedSearch *searches[2] = {&whiteSearch, &blackSearch};
+        int clocks[2] = {white.m_clockMs, black.m_clockMs};
+        // plies in a row the scores have been close to even, or one side (+1 white, -1 black) far ahead
+        int drawPlies = 0;
+        int resignPlies = 0;
+        int resignSide = 0;
+
+        auto end = [&game](Outcome outcome, const char *reason) {
+            game.m_outcome = outcome;
+            game.m_reason = reason;
+            return game;
+        };
+
+        while (true)
+        {
+            const PlayerColor us = board.getPlayerToMove();
+            const Outcome theyWin = us == PlayerColor::White ? Outcome::BlackWins : Outcome::WhiteWins;
+
+            MoveList moves;
+            board.getLegalMoves(moves);
+            if (moves.empty())
+                return board.isInCheck(us) ? end(theyWin, "checkmate") : end(Outcome::Draw, "stalemate");
+            if (board.isFiftyMoveDraw())
+                return end(Outcome::Draw, "fifty move rule");
+            if (board.isThreefoldRepetition())
+                return end(Outcome::Draw, "threefold repetition");
+            if (isInsufficientMaterial(board.getBitboards()))
+                return end(Outcome::Draw, "insufficient material");
+            if (adjudication.m_maxPlies && static_cast<int>(game.m_moves.size()) >= adjudication.m_maxPlies)
+                return end(Outcome::Draw, "move limit");
+
+            const EngineConfig &config = *configs[us];
+            search::Limits limits = config.m_limits;
+            if (config.m_clockMs)
+            {
+                search::Limits clock = search::clockLimits(clocks[us], config.m_incrementMs, 0);
+                limits.m_timeMs = clock.m_timeMs;
+                limits.m_softTimeMs = clock.m_softTimeMs;
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            search::Result result = searches[us]->run(board, limits);
+            int elapsed = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count());
+            if (config.m_clockMs)
+            {
+                clocks[us] -= elapsed;
+                if (clocks[us] < 0)
+                    return end(theyWin, "time forfeit");
+                clocks[us] += config.m_incrementMs;
+            }
+            if (result.m_bestMove.isNull() || !board.isLegal(result.m_bestMove))
+                return end(theyWin, "illegal move");
+
+            // the scores, from white's point of view, for adjudication
+            const int score = us == PlayerColor::White ? result.m_score : -result.m_score;
+            if (board.getFullmoveNumber() >= adjudication.m_drawMoveNumber && std::abs(score) <= adjudication.m_drawScore)
+                drawPlies++;
+            else
+                drawPlies = 0;
+            int ahead = score >= adjudication.m_resignScore ? 1 : score <= -adjudication.m_resignScore ? -1 : 0;
+            resignPlies = ahead != 0 && ahead == resignSide ? resignPlies + 1 : (ahead != 0 ? 1 : 0);
+            resignSide = ahead;
+
+            board.move(result.m_bestMove);
+            game.m_moves.push_back(result.m_bestMove);
+            game.m_scores.push_back(result.m_score);
+
+            // counted in plies, so both engines agree
+            if (adjudication.m_drawMoves > 0 && drawPlies >= 2 * adjudication.m_drawMoves)
+                return end(Outcome::Draw, "adjudication");
+            if (adjudication.m_resignMoves > 0 && resignPlies >= 2 * adjudication.m_resignMoves)
+                return end(resignSide > 0 ? Outcome::WhiteWins : Outcome::BlackWins, "adjudication");
+        }
+    }
+
+    std::string toPgn(const GameRecord &game, const std::string &white, const std::string &black, int round)
+    {
+        const char *result = game.m_outcome == Outcome::WhiteWins ? "1-0" : game.m_outcome == Outcome::BlackWins ? "0-1" : "1/2-1/2";
+        std::string text = "[Event \"chess_match\"]\n[Round \"" + std::to_string(round) + "\"]\n[White \"" + white +
+                           "\"]\n[Black \"" + black + "\"]\n[Result \"" + result + "\"]\n";
+        if (game.m_startFen != START_FEN)
+            text += "[SetUp \"1\"]\n[FEN \"" + game.m_startFen + "\"]\n";
+        text += "\n";
+
+        // wrapped before 80 columns, as export format wants
+        Board board(game.m_startFen);
+        std::string line;
+        auto add = [&text, &line](const std::string &token) {
+            if (!line.empty() && line.size() + 1 + token.size() > 79)
+            {
+                text += line + "\n";
+                line.clear();
+            }
+            line += (line.empty() ? "" : " ") + token;
+        };
+        for (size_t i = 0; i < game.m_moves.size(); i++)
+        {
+            // the move number stays on the same line as its move
+            std::string number;
+            if (i == 0 || board.getPlayerToMove() == PlayerColor::White)
+                number = std::to_string(board.getFullmoveNumber()) + (board.getPlayerToMove() == PlayerColor::White ? ". " : "... ");
+            add(number + pgn::toSan(board, game.m_moves[i]));
+            board.move(game.m_moves[i]);
+        }
+        add("{" + game.m_reason + "}");
+        add(result);
+        return text + line + "\n\n";
+    }
+
+    double Score::ratio() const
+    {
+        return games() ? (m_wins + 0.5 * m_draws) / games() : 0.5;
+    }
+
+    double elo(double ratio)
+    {
+        ratio = std::clamp(ratio, 0.001, 0.999);
+        return 400 * std::log10(ratio / (1 - ratio));
+    }
+
+    double eloError(const Score &score)
+    {
+        if (score.games() == 0)
+            return 0;
+        // 1.96 standard errors either side of the score, each turned into Elo
+        const double error = 1.96 * std::sqrt(variance(score) / score.games());
+        return (elo(score.ratio() + error) - elo(score.ratio() - error)) / 2;
+    }
+
+    double Sprt::llr(const Score &score) const
+    {
+        const double var = variance(score);
+        if (score.games() == 0 || var <= 0)
+            return 0;
+        const double s0 = expectedScore(m_elo0);
+        const double s1 = expectedScore(m_elo1);
+        return score.games() * (s1 - s0) * (2 * score.ratio() - s0 - s1) / (2 * var);
+    }
+
+    double Sprt::lowerBound() const
+    {
+        return std::log(m_beta / (1 - m_alpha));
+    }
+
+    double Sprt::upperBound() const
+    {
+        return std::log((1 - m_beta) / m_alpha);
+    }
+
+    Sprt::Decision Sprt::decide(const Score &score) const
+    {
+        const double ratio = llr(score);
+        if (ratio >= upperBound())
+            return Decision::AcceptH1;
+        if (ratio <= lowerBound())
+            return Decision::AcceptH0;
+        return Decision::Continue;
+    }
+}
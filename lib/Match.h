@@ -0,0 +1,113 @@
+// # Copyright (c) Dylan Leclair
+#pragma once
+
+#include "Board.h"
+#include "Move.h"
+#include "Search.h"
+#include "ThreadedSearch.h"
+
+#include <string>
+#include <vector>
+
+/// @brief games between two engine configurations, and the statistics to tell whether one is stronger.
+namespace match
+{
+    /// @brief how one side searches: node, depth and time limits per move, or a clock, and its hash size.
+    struct EngineConfig
+    {
+        std::string m_name;
+        search::Limits m_limits;
+        // a clock for the whole game, with an increment per move. when m_clockMs is set, the limits' times are
+        // worked out from it every move
+        int m_clockMs{0};
+        int m_incrementMs{0};
+        size_t m_hashMb{16};
+    };
+
+    /// @brief reads a configuration like "name=new,nodes=20000,hash=16" or "name=base,tc=10+0.1" (seconds).
+    /// the keys are name, depth, nodes, movetime (ms), tc and hash. false (with an error printed) if it can't.
+    bool parseEngine(const std::string &spec, EngineConfig &config);
+
+    /// @brief when to end a game early instead of playing it out. a score is the engines' own, in centipawns.
+    struct Adjudication
+    {
+        // a draw if, from this move on, both sides keep their score within drawScore for drawMoves moves in a row
+        int m_drawMoveNumber{40};
+        int m_drawScore{10};
+        int m_drawMoves{8};
+        // a win if both engines agree for resignMoves moves in a row that one side is at least resignScore ahead
+        int m_resignScore{1000};
+        int m_resignMoves{3};
+        // a draw after this many plies, however it stands. 0 plays on
+        int m_maxPlies{400};
+    };
+
+    enum class Outcome
+    {
+        WhiteWins,
+        BlackWins,
+        Draw,
+    };
+
+    struct GameRecord
+    {
+        Outcome m_outcome{Outcome::Draw};
+        // e.g. "checkmate", "threefold repetition", "adjudication"
+        std::string m_reason;
+        std::string m_startFen;
+        std::vector<Move> m_moves;
+        // the search's score for each move, for the side that played it
+        std::vector<int> m_scores;
+    };
+
+    /// @brief plays one game from the position (which should be legal and not over) between two engines, each
+    /// with its own search. the searches' tables are cleared first.
+    GameRecord playGame(const std::string &fen, const EngineConfig &white, const EngineConfig &black,
+                        search::ThreadedSearch &whiteSearch, search::ThreadedSearch &blackSearch,
+                        const Adjudication &adjudication);
+
+    /// @brief the game in PGN, with the engines' names as the players
+    std::string toPgn(const GameRecord &game, const std::string &white, const std::string &black, int round);
+
+    /// @brief wins, losses and draws of the first engine against the second
+    struct Score
+    {
+        int m_wins{0};
+        int m_losses{0};
+        int m_draws{0};
+
+        int games() const { return m_wins + m_losses + m_draws; }
+        // the fraction of the points won, 0.5 for an even match
+        double ratio() const;
+    };
+
+    /// @brief the Elo difference a score ratio stands for, clamped for all-won or all-lost matches
+    double elo(double ratio);
+    /// @brief the half width of the 95% confidence interval around elo(score.ratio()), from the spread of the
+    /// game results so far
+    double eloError(const Score &score);
+
+    /// @brief a sequential probability ratio test of "the first engine is elo1 stronger" against "elo0 stronger".
+    /// after every game the log likelihood ratio of the two is compared with bounds set by the chances of a false
+    /// positive (alpha) and a false negative (beta); a match can stop as soon as it crosses one.
+    struct Sprt
+    {
+        double m_elo0{0};
+        double m_elo1{5};
+        double m_alpha{0.05};
+        double m_beta{0.05};
+
+        enum class Decision
+        {
+            Continue,
+            AcceptH0, // not elo1 stronger
+            AcceptH1, // elo1 stronger
+        };
+
+        /// @brief the log likelihood ratio so far, from the normal approximation of the game results
+        double llr(const Score &score) const;
+        double lowerBound() const;
+        double upperBound() const;
+        Decision decide(const Score &score) const;
+    };
+}
@@ -4,32 +4,128 @@
 #include "PlayerColor.h"
 #include "Piece.h"
 #include <algorithm>
+#include <cstdint>
+#include <string>
+#include <utility>
 
+// a move packed in 16 bits: start square (6), destination square (6) and what kind of move it is (4).
+// squares are SQUARE(row, col), so a8 is 0 and h1 is 63.
+// the pieces involved aren't stored: the board knows what stands on the squares, and keeps the piece
+// a move captured (see Board::undo) itself.
 struct Move
 {
-    Move(PlayerColor color, Piece p, Piece takes, std::pair<int, int> start_pos, int dest_row, int dest_col)
+    enum Flag : uint8_t
     {
-        this->m_player = color;
-        this->m_piece = p;
-        this->m_start = start_pos;
-        this->m_dest = std::pair<int, int>{dest_row, dest_col};
-        this->m_takes = takes;
+        QUIET = 0,
+        DOUBLE_PUSH = 1,
+        KINGSIDE_CASTLE = 2,
+        QUEENSIDE_CASTLE = 3,
+        CAPTURE = 4,
+        EN_PASSANT = 5,
+        // promotions have bit 3 set, bit 2 if they capture, and the new piece in bits 0-1
+        KNIGHT_PROMOTION = 8,
+        BISHOP_PROMOTION = 9,
+        ROOK_PROMOTION = 10,
+        QUEEN_PROMOTION = 11,
+        KNIGHT_PROMOTION_CAPTURE = 12,
+        BISHOP_PROMOTION_CAPTURE = 13,
+        ROOK_PROMOTION_CAPTURE = 14,
+        QUEEN_PROMOTION_CAPTURE = 15,
+    };
+
+    // the null move: used to pass the turn in search (a8 to a8 is never a real move)
+    Move() = default;
+
+    Move(int start, int dest, uint8_t flags = Flag::QUIET)
+        : m_data(static_cast<uint16_t>(start | dest << 6 | flags << 12))
+    {
+    }
+
+    static Move fromRaw(uint16_t raw)
+    {
+        Move move;
+        move.m_data = raw;
+        return move;
+    }
+
+    int start() const { return m_data & 63; }
+    int dest() const { return (m_data >> 6) & 63; }
+    uint8_t flags() const { return static_cast<uint8_t>(m_data >> 12); }
+    uint16_t raw() const { return m_data; }
+
+    // (row, col) of the squares, for the grid based parts of the board
+    std::pair<int, int> startPosition() const { return {start() / 8, start() % 8}; }
+    std::pair<int, int> destPosition() const { return {dest() / 8, dest() % 8}; }
+
+    bool isNull() const { return m_data == 0; }
+    bool isCapture() const { return flags() & Flag::CAPTURE; }
+    bool isEnPassant() const { return flags() == Flag::EN_PASSANT; }
+    bool isCastling() const { return flags() == Flag::KINGSIDE_CASTLE || flags() == Flag::QUEENSIDE_CASTLE; }
+    bool isDoublePush() const { return flags() == Flag::DOUBLE_PUSH; }
+    bool isPromotion() const { return flags() & Flag::KNIGHT_PROMOTION; }
+
+    /// @brief the piece a pawn promotes to, in white (the mover's colour is the board's side to move).
+    /// EMPTY if this isn't a promotion.
+    Piece promotion() const
+    {
+        static const Piece pieces[4] = {Piece::WHITE_KNIGHT, Piece::WHITE_BISHOP, Piece::WHITE_ROOK, Piece::WHITE_QUEEN};
+        return isPromotion() ? pieces[flags() & 3] : Piece::EMPTY;
     }
 
-    Move(PlayerColor color, Piece p, Piece takes, std::pair<int, int> start_pos, int dest_row, int dest_col, bool castling)
+    bool operator==(const Move &other) const { return m_data == other.m_data; }
+    bool operator!=(const Move &other) const { return m_data != other.m_data; }
+
+    // long algebraic notation, as used by perft divide and UCI (e.g. "e2e4", "e7e8q")
+    std::string toString() const
     {
-        this->m_player = color;
-        this->m_piece = p;
-        this->m_start = start_pos;
-        this->m_dest = std::pair<int, int>{dest_row, dest_col};
-        this->m_takes = takes;
-        this->m_castling = castling;
+        std::string result{
+            static_cast<char>('a' + start() % 8), static_cast<char>('8' - start() / 8),
+            static_cast<char>('a' + dest() % 8), static_cast<char>('8' - dest() / 8)};
+        if (isPromotion())
+        {
+            result += "nbrq"[flags() & 3];
+        }
+        return result;
     }
 
-    PlayerColor m_player;
-    Piece m_piece;
-    Piece m_takes;
-    std::pair<int, int> m_start;
-    std::pair<int, int> m_dest;
-    bool m_castling{false};
+private:
+    uint16_t m_data{0};
+};
+
+/// @brief fixed capacity list of moves on the stack, so generating moves never allocates.
+/// 256 is more than the most moves any legal position has (218).
+class MoveList
+{
+public:
+    static const int CAPACITY = 256;
+
+    // the moves are left uninitialized, only the first size() are ever read
+    MoveList() {}
+
+    void push_back(const Move &move) { m_moves[m_size++] = move; }
+    template <typename... Args>
+    void emplace_back(Args &&...args) { m_moves[m_size++] = Move(std::forward<Args>(args)...); }
+
+    void clear() { m_size = 0; }
+    // drops everything from the iterator on, like vector::erase(it, end())
+    void erase(Move *from) { m_size = static_cast<int>(from - m_moves); }
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    Move &operator[](size_t i) { return m_moves[i]; }
+    const Move &operator[](size_t i) const { return m_moves[i]; }
+    Move &back() { return m_moves[m_size - 1]; }
+
+    Move *begin() { return m_moves; }
+    Move *end() { return m_moves + m_size; }
+    const Move *begin() const { return m_moves; }
+    const Move *end() const { return m_moves + m_size; }
+
+private:
+    union
+    {
+        Move m_moves[CAPACITY];
+    };
+    int m_size{0};
 };
@@ -0,0 +1,140 @@
+// # Copyright (c) Dylan Leclair
+#include "MovePicker.h"
+#include "Evaluate.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace search
+{
+    void History::clear()
+    {
+        std::memset(m_scores, 0, sizeof(m_scores));
+    }
+
+    void History::update(PlayerColor side, Move move, int bonus)
+    {
+        bonus = std::clamp(bonus, -MAX, MAX);
+        int &score = m_scores[side][move.start()][move.dest()];
+        score += bonus - score * std::abs(bonus) / MAX;
+    }
+
+    MovePicker::MovePicker(Board &board, Move hashMove, const Move (&killers)[2], const History &history)
+        : m_board(board),
+          m_history(history),
+          m_hashMove(hashMove),
+          m_killers{killers[0], killers[1]}
+    {
+        if (m_hashMove.isNull() || !m_board.isLegal(m_hashMove))
+        {
+            m_hashMove = Move();
+            m_stage = Stage::GenerateCaptures;
+        }
+    }
+
+    Move MovePicker::pickBest(MoveList &moves, int *scores)
+    {
+        size_t best = m_current;
+        for (size_t i = m_current + 1; i < moves.size(); i++)
+        {
+            if (scores[i] > scores[best])
+                best = i;
+        }
+        std::swap(moves[m_current], moves[best]);
+        std::swap(scores[m_current], scores[best]);
+        return moves[m_current++];
+    }
+
+    bool MovePicker::isSpecial(Move move) const
+    {
+        return move == m_hashMove || move == m_killers[0] || move == m_killers[1];
+    }
+
+    Move MovePicker::next()
+    {
+        switch (m_stage)
+        {
+        case Stage::HashMove:
+            m_stage = Stage::GenerateCaptures;
+            return m_hashMove;
+
+        case Stage::GenerateCaptures:
+        {
+            const Bitboards &bitboards = m_board.getBitboards();
+            m_board.getLegalCaptures(m_moves);
+            for (size_t i = 0; i < m_moves.size(); i++)
+            {
+                // most valuable victim, then least valuable attacker. the exchange is only worked out once picked
+                const Move &move = m_moves[i];
+                Piece victim = move.isEnPassant() ? Piece::WHITE_PAWN : bitboards.at(move.dest());
+                m_scores[i] = 10 * (eval::pieceValues[victim] + eval::pieceValues[move.promotion()]) -
+                              eval::pieceValues[bitboards.at(move.start())] / 10;
+            }
+            m_current = 0;
+            m_stage = Stage::GoodCaptures;
+        }
+            [[fallthrough]];
+
+        case Stage::GoodCaptures:
+            while (m_current < m_moves.size())
+            {
+                Move move = pickBest(m_moves, m_scores);
+                if (move == m_hashMove)
+                    continue;
+                if (eval::see(m_board, move) < 0)
+                {
+                    m_badCaptures.push_back(move);
+                    continue;
+                }
+                return move;
+            }
+            m_stage = Stage::Killers;
+            [[fallthrough]];
+
+        case Stage::Killers:
+            while (m_killerIndex < 2)
+            {
+                // the killers are quiet moves from other positions: they only count if they're legal and still quiet here
+                Move killer = m_killers[m_killerIndex++];
+                if (!killer.isNull() && killer != m_hashMove && !killer.isCapture() && !killer.isPromotion() && m_board.isLegal(killer))
+                    return killer;
+            }
+            m_stage = Stage::GenerateQuiets;
+            [[fallthrough]];
+
+        case Stage::GenerateQuiets:
+        {
+            PlayerColor side = m_board.getPlayerToMove();
+            m_moves.clear();
+            m_board.getLegalQuiets(m_moves);
+            for (size_t i = 0; i < m_moves.size(); i++)
+                m_scores[i] = m_history.get(side, m_moves[i]);
+            m_current = 0;
+            m_stage = Stage::Quiets;
+        }
+            [[fallthrough]];
+
+        case Stage::Quiets:
+            while (m_current < m_moves.size())
+            {
+                Move move = pickBest(m_moves, m_scores);
+                if (!isSpecial(move))
+                    return move;
+            }
+            m_current = 0;
+            m_stage = Stage::BadCaptures;
+            [[fallthrough]];
+
+        case Stage::BadCaptures:
+            if (m_current < m_badCaptures.size())
+                return m_badCaptures[m_current++];
+            m_stage = Stage::Done;
+            [[fallthrough]];
+
+        case Stage::Done:
+        default:
+            return Move();
+        }
+    }
+}
@@ -0,0 +1,75 @@
+// # Copyright (c) Dylan Leclair
+#pragma once
+
+#include "Board.h"
+#include "Move.h"
+
+namespace search
+{
+    /// @brief how often each quiet move (by side, start and destination square) has caused a cutoff, for ordering
+    /// quiet moves. good moves tend to stay good across the tree, wherever the other pieces are.
+    class History
+    {
+    public:
+        // scores stay within +-MAX, the more extreme they already are the less a bonus moves them
+        static constexpr int MAX = 16384;
+
+        void clear();
+        int get(PlayerColor side, Move move) const { return m_scores[side][move.start()][move.dest()]; }
+        // a positive bonus for a move that caused a cutoff, negative for the ones tried before it that didn't
+        void update(PlayerColor side, Move move, int bonus);
+
+    private:
+        int m_scores[2][64][64];
+    };
+
+    /// @brief hands out the moves of a position one at a time, best guess first, generating them in stages:
+    ///
+    /// 1. the hash move (checked to be legal, it may come from another position)
+    /// 2. captures and promotions that don't lose material (by SEE), most valuable victim first
+    /// 3. the killer moves: quiet moves that caused a cutoff at the same ply elsewhere in the tree
+    /// 4. the other quiet moves, by history score
+    /// 5. the captures that lose material
+    ///
+    /// nothing is generated for a stage until it's reached, so a node that cuts off on the hash move or a capture
+    /// never generates its quiet moves. every legal move comes out exactly once.
+    class MovePicker
+    {
+    public:
+        MovePicker(Board &board, Move hashMove, const Move (&killers)[2], const History &history);
+
+        /// @brief the next move to search, or the null move when there are none left
+        Move next();
+
+    private:
+        enum class Stage
+        {
+            HashMove,
+            GenerateCaptures,
+            GoodCaptures,
+            Killers,
+            GenerateQuiets,
+            Quiets,
+            BadCaptures,
+            Done,
+        };
+
+        // takes the highest scored move out of [m_current, moves.size()), selection sort one step at a time:
+        // most nodes only ever look at the first few
+        Move pickBest(MoveList &moves, int *scores);
+        // moves handed out by an earlier stage
+        bool isSpecial(Move move) const;
+
+        Board &m_board;
+        const History &m_history;
+        Stage m_stage{Stage::HashMove};
+        Move m_hashMove;
+        Move m_killers[2];
+        int m_killerIndex{0};
+
+        size_t m_current{0};
+        MoveList m_moves;
+        int m_scores[MoveList::CAPACITY];
+        MoveList m_badCaptures;
+    };
+}
@@ -0,0 +1,425 @@
+// # Copyright (c) Dylan Leclair
+#include "Nnue.h"
+#include "Board.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define NNUE_X86
+#include <immintrin.h>
+#endif
+
+namespace nnue
+{
+    namespace
+    {
+        const char MAGIC[8] = {'C', 'P', 'S', 'C', 'N', 'N', 'U', 'E'};
+        const uint32_t VERSION = 1;
+        const size_t HEADER_SIZE = 64;
+        const size_t ALIGNMENT = 64;
+
+        size_t padded(size_t bytes) { return (bytes + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT; }
+
+        // where each part of the network starts in the file, after the header
+        struct Layout
+        {
+            size_t m_hiddenBiases, m_hiddenWeights, m_l1Biases, m_l1Weights, m_l2Biases, m_l2Weights;
+            size_t m_outputBias, m_outputWeights, m_size;
+
+            Layout()
+            {
+                size_t offset = HEADER_SIZE;
+                auto next = [&](size_t bytes) {
+                    size_t start = offset;
+                    offset += padded(bytes);
+                    return start;
+                };
+                m_hiddenBiases = next(HIDDEN * sizeof(int16_t));
+                m_hiddenWeights = next(size_t(INPUTS) * HIDDEN * sizeof(int16_t));
+                m_l1Biases = next(L1 * sizeof(int32_t));
+                m_l1Weights = next(L1 * 2 * HIDDEN * sizeof(int8_t));
+                m_l2Biases = next(L2 * sizeof(int32_t));
+                m_l2Weights = next(L2 * L1 * sizeof(int8_t));
+                m_outputBias = next(sizeof(int32_t));
+                m_outputWeights = next(L2 * sizeof(int8_t));
+                m_size = offset;
+            }
+        };
+        const Layout layout;
+
+        const uint32_t header[6] = {VERSION, INPUTS, HIDDEN, L1, L2, 1};
+
+        /// @brief a network file in memory. the weights are used straight out of it, nothing is copied.
+        class Network : public MappedFile
+        {
+        public:
+            template <typename T>
+            const T *at(size_t offset) const { return reinterpret_cast<const T *>(data() + offset); }
+        };
+
+        std::unique_ptr<Network> network;
+        uint32_t loads = 0;
+
+        // pointers into the loaded network, looked up once per load instead of on every evaluation
+        const int16_t *hiddenBiases;
+        const int16_t *hiddenWeights;
+        const int32_t *l1Biases;
+        const int8_t *l1Weights;
+        const int32_t *l2Biases;
+        const int8_t *l2Weights;
+        int32_t outputBias;
+        const int8_t *outputWeights;
+
+        // ---- kernels ----
+
+        void addFeatureScalar(int16_t *accumulator, const int16_t *weights)
+        {
+            for (int i = 0; i < HIDDEN; i++)
+                accumulator[i] += weights[i];
+        }
+
+        void subFeatureScalar(int16_t *accumulator, const int16_t *weights)
+        {
+            for (int i = 0; i < HIDDEN; i++)
+                accumulator[i] -= weights[i];
+        }
+
+        void clippedReluScalar(const int16_t *input, uint8_t *output, int size)
+        {
+            for (int i = 0; i < size; i++)
+                output[i] = static_cast<uint8_t>(std::clamp<int>(input[i], 0, ACTIVATION_MAX));
+        }
+
+        int32_t dotScalar(const uint8_t *input, const int8_t *weights, int size)
+        {
+            int32_t sum = 0;
+            for (int i = 0; i < size; i++)
+                sum += input[i] * weights[i];
+            return sum;
+        }
+
+        const Kernels scalarKernels{"scalar", addFeatureScalar, subFeatureScalar, clippedReluScalar, dotScalar};
+
+#ifdef NNUE_X86
+        // compiled for the newer instruction sets regardless of the build flags, and only called once
+        // the CPU is known to have them
+
+        __attribute__((target("sse4.1"))) void addFeatureSse41(int16_t *accumulator, const int16_t *weights)
+        {
+            for (int i = 0; i < HIDDEN; i += 8)
+            {
+                __m128i *a = reinterpret_cast<__m128i *>(accumulator + i);
+                __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i *>(weights + i));
+                _mm_storeu_si128(a, _mm_add_epi16(_mm_loadu_si128(a), w));
+            }
+        }
+
+        __attribute__((target("sse4.1"))) void subFeatureSse41(int16_t *accumulator, const int16_t *weights)
+        {
+            for (int i = 0; i < HIDDEN; i += 8)
+            {
+                __m128i *a = reinterpret_cast<__m128i *>(accumulator + i);
+                __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i *>(weights + i));
+                _mm_storeu_si128(a, _mm_sub_epi16(_mm_loadu_si128(a), w));
+            }
+        }
+
+        __attribute__((target("sse4.1"))) void clippedReluSse41(const int16_t *input, uint8_t *output, int size)
+        {
+            const __m128i zero = _mm_setzero_si128();
+            for (int i = 0; i < size; i += 16)
+            {
+                __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input + i));
+                __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input + i + 8));
+                // packing saturates to [-128, 127], the max takes care of the rest
+                __m128i packed = _mm_max_epi8(_mm_packs_epi16(low, high), zero);
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(output + i), packed);
+            }
+        }
+
+        __attribute__((target("sse4.1"))) int32_t dotSse41(const uint8_t *input, const int8_t *weights, int size)
+        {
+            const __m128i ones = _mm_set1_epi16(1);
+            __m128i sum = _mm_setzero_si128();
+            for (int i = 0; i < size; i += 16)
+            {
+                __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input + i));
+                __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i *>(weights + i));
+                // pairs of products can't saturate 16 bits: the inputs are at most ACTIVATION_MAX
+                __m128i products = _mm_maddubs_epi16(in, w);
+                sum = _mm_add_epi32(sum, _mm_madd_epi16(products, ones));
+            }
+            sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+            sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+            return _mm_cvtsi128_si32(sum);
+        }
+
+        __attribute__((target("avx2"))) void addFeatureAvx2(int16_t *accumulator, const int16_t *weights)
+        {
+            for (int i = 0; i < HIDDEN; i += 16)
+            {
+                __m256i *a = reinterpret_cast<__m256i *>(accumulator + i);
+                __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(weights + i));
+                _mm256_storeu_si256(a, _mm256_add_epi16(_mm256_loadu_si256(a), w));
+            }
+        }
+
+        __attribute__((target("avx2"))) void subFeatureAvx2(int16_t *accumulator, const int16_t *weights)
+        {
+            for (int i = 0; i < HIDDEN; i += 16)
+            {
+                __m256i *a = reinterpret_cast<__m256i *>(accumulator + i);
+                __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(weights + i));
+                _mm256_storeu_si256(a, _mm256_sub_epi16(_mm256_loadu_si256(a), w));
+            }
+        }
+
+        __attribute__((target("avx2"))) void clippedReluAvx2(const int16_t *input, uint8_t *output, int size)
+        {
+            const __m256i zero = _mm256_setzero_si256();
+            for (int i = 0; i < size; i += 32)
+            {
+                __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(input + i));
+                __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(input + i + 16));
+                // the pack works on each 128 bit lane separately, the permute puts the quarters back in order
+                __m256i packed = _mm256_max_epi8(_mm256_packs_epi16(low, high), zero);
+                packed = _mm256_permute4x64_epi64(packed, 0xD8);
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(output + i), packed);
+            }
+        }
+
+        __attribute__((target("avx2"))) int32_t dotAvx2(const uint8_t *input, const int8_t *weights, int size)
+        {
+            const __m256i ones = _mm256_set1_epi16(1);
+            __m256i sum = _mm256_setzero_si256();
+            for (int i = 0; i < size; i += 32)
+            {
+                __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(input + i));
+                __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(weights + i));
+                __m256i products = _mm256_maddubs_epi16(in, w);
+                sum = _mm256_add_epi32(sum, _mm256_madd_epi16(products, ones));
+            }
+            __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+            half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+            half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+            return _mm_cvtsi128_si32(half);
+        }
+
+        const Kernels sse41Kernels{"sse4.1", addFeatureSse41, subFeatureSse41, clippedReluSse41, dotSse41};
+        const Kernels avx2Kernels{"avx2", addFeatureAvx2, subFeatureAvx2, clippedReluAvx2, dotAvx2};
+#endif
+
+        const Kernels &bestKernels()
+        {
+#ifdef NNUE_X86
+            // this runs before main, possibly before the compiler's own CPU detection has
+            __builtin_cpu_init();
+#endif
+            for (Isa isa : {Isa::Avx2, Isa::Sse41})
+            {
+                if (const Kernels *found = kernelsFor(isa))
+                    return *found;
+            }
+            return scalarKernels;
+        }
+
+        const Kernels &active = bestKernels();
+
+        // piece types in feature order, indexed by Piece; kings (and anything else) are -1
+        const int pieceTypes[15] = {-1, 0, 1, 2, 3, 4, -1, 0, 1, 2, 3, 4, -1, -1, -1};
+
+        int kingSquare(const Bitboards &bitboards, PlayerColor perspective)
+        {
+            Bitboard king = bitboards.pieces(perspective == PlayerColor::White ? Piece::WHITE_KING : Piece::BLACK_KING);
+            // positions without a king (tests, setups) just use the corner
+            return king ? bitboard::lsb(king) : 0;
+        }
+
+        const int16_t *featureWeights(int feature) { return hiddenWeights + size_t(feature) * HIDDEN; }
+    }
+
+    Weights::Weights()
+        : m_hiddenBiases(HIDDEN),
+          m_hiddenWeights(size_t(INPUTS) * HIDDEN),
+          m_l1Biases(L1),
+          m_l1Weights(L1 * 2 * HIDDEN),
+          m_l2Biases(L2),
+          m_l2Weights(L2 * L1),
+          m_outputWeights(L2)
+    {
+    }
+
+    bool load(const std::string &path)
+    {
+        std::unique_ptr<Network> loaded(new Network());
+        if (!loaded->open(path))
+        {
+            std::cout << "Error at nnue::load: can't open " << path << std::endl;
+            return false;
+        }
+        if (loaded->size() != layout.m_size || std::memcmp(loaded->data(), MAGIC, sizeof(MAGIC)) != 0 ||
+            std::memcmp(loaded->data() + sizeof(MAGIC), header, sizeof(header)) != 0)
+        {
+            std::cout << "Error at nnue::load: " << path << " isn't a version " << VERSION << " network of this size" << std::endl;
+            return false;
+        }
+
+        network = std::move(loaded);
+        loads++;
+        hiddenBiases = network->at<int16_t>(layout.m_hiddenBiases);
+        hiddenWeights = network->at<int16_t>(layout.m_hiddenWeights);
+        l1Biases = network->at<int32_t>(layout.m_l1Biases);
+        l1Weights = network->at<int8_t>(layout.m_l1Weights);
+        l2Biases = network->at<int32_t>(layout.m_l2Biases);
+        l2Weights = network->at<int8_t>(layout.m_l2Weights);
+        outputBias = *network->at<int32_t>(layout.m_outputBias);
+        outputWeights = network->at<int8_t>(layout.m_outputWeights);
+        return true;
+    }
+
+    void unload()
+    {
+        network.reset();
+        loads++;
+    }
+
+    bool isLoaded() { return network != nullptr; }
+
+    uint32_t generation() { return loads; }
+
+    bool save(const std::string &path, const Weights &weights)
+    {
+        FILE *file = std::fopen(path.c_str(), "wb");
+        if (!file)
+            return false;
+
+        bool ok = true;
+        size_t written = 0;
+        // zeroes up to where the next part starts
+        auto pad = [&](size_t offset) {
+            static const char zeroes[ALIGNMENT] = {};
+            ok = ok && std::fwrite(zeroes, 1, offset - written, file) == offset - written;
+            written = offset;
+        };
+        auto write = [&](const void *data, size_t bytes, size_t offset) {
+            pad(offset);
+            ok = ok && std::fwrite(data, 1, bytes, file) == bytes;
+            written = offset + bytes;
+        };
+        auto writeVector = [&](const auto &values, size_t expected, size_t offset) {
+            ok = ok && values.size() == expected;
+            write(values.data(), expected * sizeof(values[0]), offset);
+        };
+
+        write(MAGIC, sizeof(MAGIC), 0);
+        write(header, sizeof(header), sizeof(MAGIC));
+        writeVector(weights.m_hiddenBiases, HIDDEN, layout.m_hiddenBiases);
+        writeVector(weights.m_hiddenWeights, size_t(INPUTS) * HIDDEN, layout.m_hiddenWeights);
+        writeVector(weights.m_l1Biases, L1, layout.m_l1Biases);
+        writeVector(weights.m_l1Weights, L1 * 2 * HIDDEN, layout.m_l1Weights);
+        writeVector(weights.m_l2Biases, L2, layout.m_l2Biases);
+        writeVector(weights.m_l2Weights, L2 * L1, layout.m_l2Weights);
+        write(&weights.m_outputBias, sizeof(int32_t), layout.m_outputBias);
+        writeVector(weights.m_outputWeights, L2, layout.m_outputWeights);
+        pad(layout.m_size);
+
+        return std::fclose(file) == 0 && ok;
+    }
+
+    int featureIndex(PlayerColor perspective, int kingSquare, Piece piece, int square)
+    {
+        // black sees the board upside down, so its pieces are on the "near" ranks too
+        int flip = perspective == PlayerColor::White ? 0 : 56;
+        int relativeColor = getPieceColor(piece) == perspective ? 0 : 1;
+        return (kingSquare ^ flip) * PIECE_SQUARES + (pieceTypes[piece] * 2 + relativeColor) * 64 + (square ^ flip);
+    }
+
+    void refresh(Accumulator &accumulator, const Bitboards &bitboards, PlayerColor perspective)
+    {
+        int16_t *values = accumulator.m_values[perspective];
+        std::memcpy(values, hiddenBiases, sizeof(accumulator.m_values[perspective]));
+
+        int king = kingSquare(bitboards, perspective);
+        Bitboard pieces = bitboards.occupied() & ~bitboards.pieces(Piece::WHITE_KING) & ~bitboards.pieces(Piece::BLACK_KING);
+        while (pieces)
+        {
+            int square = bitboard::popLsb(pieces);
+            active.m_addFeature(values, featureWeights(featureIndex(perspective, king, bitboards.at(square), square)));
+        }
+        accumulator.m_computed[perspective] = true;
+    }
+
+    void update(Accumulator &accumulator, const Accumulator &previous, const DirtyPieces &dirty,
+                const Bitboards &bitboards, PlayerColor perspective)
+    {
+        int16_t *values = accumulator.m_values[perspective];
+        std::memcpy(values, previous.m_values[perspective], sizeof(accumulator.m_values[perspective]));
+
+        // the perspective's king hasn't moved, so it's where it is now
+        int king = kingSquare(bitboards, perspective);
+        for (int i = 0; i < dirty.m_count; i++)
+        {
+            const DirtyPieces::Change &change = dirty.m_changes[i];
+            if (pieceTypes[change.m_piece] < 0)
+                continue;
+            if (change.m_from >= 0)
+                active.m_subFeature(values, featureWeights(featureIndex(perspective, king, change.m_piece, change.m_from)));
+            if (change.m_to >= 0)
+                active.m_addFeature(values, featureWeights(featureIndex(perspective, king, change.m_piece, change.m_to)));
+        }
+        accumulator.m_computed[perspective] = true;
+    }
+
+    int evaluate(const Board &board)
+    {
+        const Accumulator &accumulator = board.getAccumulator();
+        PlayerColor us = board.getPlayerToMove();
+        PlayerColor them = us == PlayerColor::White ? PlayerColor::Black : PlayerColor::White;
+
+        alignas(64) uint8_t input[2 * HIDDEN];
+        active.m_clippedRelu(accumulator.m_values[us], input, HIDDEN);
+        active.m_clippedRelu(accumulator.m_values[them], input + HIDDEN, HIDDEN);
+
+        alignas(64) uint8_t hidden1[L1];
+        for (int i = 0; i < L1; i++)
+        {
+            int32_t sum = l1Biases[i] + active.m_dot(input, l1Weights + i * 2 * HIDDEN, 2 * HIDDEN);
+            hidden1[i] = static_cast<uint8_t>(std::clamp(sum >> WEIGHT_SHIFT, 0, ACTIVATION_MAX));
+        }
+
+        alignas(64) uint8_t hidden2[L2];
+        for (int i = 0; i < L2; i++)
+        {
+            int32_t sum = l2Biases[i] + active.m_dot(hidden1, l2Weights + i * L1, L1);
+            hidden2[i] = static_cast<uint8_t>(std::clamp(sum >> WEIGHT_SHIFT, 0, ACTIVATION_MAX));
+        }
+
+        int32_t output = outputBias + active.m_dot(hidden2, outputWeights, L2);
+        // well clear of the mate scores, whatever the network says
+        return std::clamp(output / OUTPUT_SCALE, -10000, 10000);
+    }
+
+    const Kernels *kernelsFor(Isa isa)
+    {
+        switch (isa)
+        {
+        case Isa::Scalar:
+            return &scalarKernels;
+#ifdef NNUE_X86
+        case Isa::Sse41:
+            return __builtin_cpu_supports("sse4.1") ? &sse41Kernels : nullptr;
+        case Isa::Avx2:
+            return __builtin_cpu_supports("avx2") ? &avx2Kernels : nullptr;
+#endif
+        default:
+            return nullptr;
+        }
+    }
+
+    const Kernels &kernels() { return active; }
+}
@@ -0,0 +1,141 @@
+// # Copyright (c) Dylan Leclair
+#pragma once
+
+#include "Bitboard.h"
+#include "Piece.h"
+#include "PlayerColor.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Board;
+
+/// @brief an efficiently updatable neural network evaluation (NNUE), run on the CPU in integer arithmetic.
+///
+/// the inputs are HalfKP features: for each side ("perspective"), one per (own king square, non-king piece, square),
+/// with the board flipped for black so both sides look at the position the same way. a move only turns a few
+/// of those on or off, so the first layer's output (the accumulator) is kept per ply and updated from the moves
+/// made instead of summed from scratch, unless the perspective's own king moved. the rest of the network is small:
+///
+///     2 x HIDDEN (side to move first) -> L1 -> L2 -> 1, with clipped ReLU in between
+///
+/// networks are loaded from a binary file (see load) that is mapped into memory, not read, so starting up
+/// with a big network costs nothing until the weights are used. with no network loaded, eval::evaluate
+/// keeps using the piece-square evaluation.
+namespace nnue
+{
+    const int KING_SQUARES = 64;
+    const int PIECE_SQUARES = 10 * 64; // pawn, rook, knight, bishop, queen of either colour on every square
+    const int INPUTS = KING_SQUARES * PIECE_SQUARES;
+    const int HIDDEN = 256;
+    const int L1 = 32;
+    const int L2 = 32;
+
+    // activations are clipped to [0, ACTIVATION_MAX] and stored as bytes between layers
+    const int ACTIVATION_MAX = 127;
+    // hidden layer weights are scaled by 2^WEIGHT_SHIFT
+    const int WEIGHT_SHIFT = 6;
+    // the output divided by this is centipawns
+    const int OUTPUT_SCALE = 16;
+
+    /// @brief the pieces a move took off or put on the board, recorded by Board::move so the accumulator can be
+    /// brought up to date later without looking at the move again. a square of -1 means none: a piece only removed
+    /// (captured, or the pawn that promoted) has no m_to, a piece only added (what it promoted to) has no m_from.
+    struct DirtyPieces
+    {
+        struct Change
+        {
+            Piece m_piece;
+            int8_t m_from;
+            int8_t m_to;
+        };
+
+        // the most a move changes: a pawn capturing and promoting (the captured piece, the pawn, the new piece)
+        Change m_changes[3]{};
+        uint8_t m_count{0};
+
+        void add(Piece piece, int from, int to)
+        {
+            m_changes[m_count++] = {piece, static_cast<int8_t>(from), static_cast<int8_t>(to)};
+        }
+    };
+
+    /// @brief the first layer's output for both perspectives, indexed by PlayerColor.
+    struct alignas(64) Accumulator
+    {
+        int16_t m_values[2][HIDDEN];
+        // whether each perspective is up to date with the position it belongs to
+        bool m_computed[2]{false, false};
+    };
+
+    /// @brief the weights in the order they're stored in the file. used to write networks (e.g. from a trainer);
+    /// a loaded network points straight into the mapped file instead.
+    struct Weights
+    {
+        std::vector<int16_t> m_hiddenBiases;  // HIDDEN
+        std::vector<int16_t> m_hiddenWeights; // INPUTS x HIDDEN, one row of HIDDEN per feature
+        std::vector<int32_t> m_l1Biases;      // L1
+        std::vector<int8_t> m_l1Weights;      // L1 x 2 * HIDDEN, one row per output
+        std::vector<int32_t> m_l2Biases;      // L2
+        std::vector<int8_t> m_l2Weights;      // L2 x L1
+        int32_t m_outputBias{0};
+        std::vector<int8_t> m_outputWeights; // L2
+
+        // every vector sized for the network, filled with zeroes
+        Weights();
+    };
+
+    /// @brief maps a network file and makes it the one used by evaluate, replacing any loaded before.
+    /// the file is a 64 byte header ("CPSCNNUE", then the format version and the layer sizes as little endian
+    /// 32 bit integers) followed by the Weights in order, little endian, each padded to a multiple of 64 bytes.
+    /// on failure (missing file, wrong version or sizes, truncated) prints an error and keeps the network there was.
+    bool load(const std::string &path);
+    // goes back to the piece-square evaluation
+    void unload();
+    bool isLoaded();
+    // writes a network in the format load reads
+    bool save(const std::string &path, const Weights &weights);
+
+    /// @brief counts loads, so a board can tell its accumulators were computed with a network that's gone.
+    uint32_t generation();
+
+    /// @brief the feature for a piece on a square, seen from the perspective's side with its king on kingSquare.
+    /// kings themselves aren't features.
+    int featureIndex(PlayerColor perspective, int kingSquare, Piece piece, int square);
+
+    // the perspective's half of the accumulator from scratch
+    void refresh(Accumulator &accumulator, const Bitboards &bitboards, PlayerColor perspective);
+    // the perspective's half from the previous ply's, given what the move between changed (not the perspective's king)
+    void update(Accumulator &accumulator, const Accumulator &previous, const DirtyPieces &dirty,
+                const Bitboards &bitboards, PlayerColor perspective);
+
+    /// @brief centipawns from the side to move's point of view. only valid with a network loaded.
+    int evaluate(const Board &board);
+
+    /// @brief the inner loops, one set per instruction set. the fastest the CPU supports is picked when the program
+    /// starts; the others are only reachable for testing.
+    struct Kernels
+    {
+        const char *m_name;
+        // accumulator += / -= one feature's weights (HIDDEN values)
+        void (*m_addFeature)(int16_t *accumulator, const int16_t *weights);
+        void (*m_subFeature)(int16_t *accumulator, const int16_t *weights);
+        // clamps to [0, ACTIVATION_MAX]. size is a multiple of 32
+        void (*m_clippedRelu)(const int16_t *input, uint8_t *output, int size);
+        // sum of input * weights. size is a multiple of 32
+        int32_t (*m_dot)(const uint8_t *input, const int8_t *weights, int size);
+    };
+
+    enum class Isa
+    {
+        Scalar,
+        Sse41,
+        Avx2,
+    };
+
+    // the kernels for an instruction set, or nullptr if this build or CPU can't run them
+    const Kernels *kernelsFor(Isa isa);
+    // the ones in use
+    const Kernels &kernels();
+}
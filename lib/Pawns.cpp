@@ -0,0 +1,138 @@
+// # Copyright (c) Dylan Leclair
+#include "Pawns.h"
+#include "Board.h"
+#include "Attacks.h"
+
+namespace eval
+{
+    namespace
+    {
+        const Bitboard FILE_A = 0x0101010101010101ULL;
+
+        // by how far the pawn has come, 1 on its starting row up to 6 one step from promoting
+        const Score PASSED[8] = {{0, 0}, {0, 5}, {5, 10}, {10, 25}, {20, 45}, {35, 75}, {60, 120}, {0, 0}};
+        const Score ISOLATED{-10, -15};
+        const Score DOUBLED{-10, -20};
+        const Score BACKWARD{-8, -10};
+        // for each of the three files in front of the king: a pawn one row up, two rows up, or none
+        const int SHIELD_NEAR = 15;
+        const int SHIELD_FAR = 8;
+        const int SHIELD_MISSING = -10;
+
+        Bitboard fileOf(int square) { return FILE_A << COL_OF(square); }
+
+        Bitboard adjacentFiles(int square)
+        {
+            const int col = COL_OF(square);
+            return (col > 0 ? FILE_A << (col - 1) : 0) | (col < 7 ? FILE_A << (col + 1) : 0);
+        }
+
+        // the rows in front of the square, from the colour's side (white goes towards row 0)
+        Bitboard rowsAhead(PlayerColor color, int square)
+        {
+            const int row = ROW_OF(square);
+            if (color == PlayerColor::White)
+                return (static_cast<Bitboard>(1) << (8 * row)) - 1;
+            return row == 7 ? 0 : ~((static_cast<Bitboard>(1) << (8 * (row + 1))) - 1);
+        }
+
+        // the row from the colour's side: 0 is its back rank
+        int relativeRow(PlayerColor color, int square)
+        {
+            return color == PlayerColor::White ? 7 - ROW_OF(square) : ROW_OF(square);
+        }
+
+        Score evaluateSide(PlayerColor us, Bitboard ours, Bitboard theirs, PawnEntry &entry)
+        {
+            Score score;
+            Bitboard pawns = ours;
+            while (pawns)
+            {
+                const int square = bitboard::popLsb(pawns);
+                const Bitboard ahead = rowsAhead(us, square);
+                const Bitboard neighbours = ours & adjacentFiles(square);
+
+                if (!(theirs & ahead & (fileOf(square) | adjacentFiles(square))))
+                {
+                    entry.m_passed[us] |= SQUARE_BB(square);
+                    score += PASSED[relativeRow(us, square)];
+                }
+                // counted for each pawn with one of ours in front of it
+                if (ours & ahead & fileOf(square))
+                    score += DOUBLED;
+                if (!neighbours)
+                    score += ISOLATED;
+                else if (!(neighbours & ~ahead))
+                {
+                    // every neighbour has gone past it, and stepping up walks into a pawn's attack
+                    const int stop = square + (us == PlayerColor::White ? -8 : 8);
+                    if (stop >= 0 && stop < 64 && (attacks::pawnAttacks[us][stop] & theirs))
+                        score += BACKWARD;
+                }
+            }
+
+            for (int col = 0; col < 8; col++)
+            {
+                // the files next to the king, moved in from the edge of the board so there are always three
+                const int centre = col == 0 ? 1 : col == 7 ? 6 : col;
+                int shield = 0;
+                for (int file = centre - 1; file <= centre + 1; file++)
+                {
+                    const int nearRow = us == PlayerColor::White ? 6 : 1;
+                    const int farRow = us == PlayerColor::White ? 5 : 2;
+                    if (ours & SQUARE_BB(SQUARE(nearRow, file)))
+                        shield += SHIELD_NEAR;
+                    else if (ours & SQUARE_BB(SQUARE(farRow, file)))
+                        shield += SHIELD_FAR;
+                    else
+                        shield += SHIELD_MISSING;
+                }
+                entry.m_shield[us][col] = static_cast<int16_t>(shield);
+            }
+            return score;
+        }
+    }
+
+    PawnEntry evaluatePawns(Bitboard whitePawns, Bitboard blackPawns)
+    {
+        PawnEntry entry;
+        entry.m_score = evaluateSide(PlayerColor::White, whitePawns, blackPawns, entry) -
+                        evaluateSide(PlayerColor::Black, blackPawns, whitePawns, entry);
+        return entry;
+    }
+
+    PawnTable::PawnTable(size_t kilobytes)
+    {
+        size_t entries = 1;
+        while (entries * 2 * sizeof(PawnEntry) <= kilobytes * 1024)
+            entries *= 2;
+        m_entries.reset(new PawnEntry[entries]);
+        m_mask = entries - 1;
+        clear();
+    }
+
+    const PawnEntry &PawnTable::probe(const Board &board)
+    {
+        const uint64_t key = board.getPawnHash();
+        PawnEntry &entry = m_entries[key & m_mask];
+        m_probes++;
+        if (entry.m_key == key)
+        {
+            m_hits++;
+            return entry;
+        }
+        const Bitboards &bitboards = board.getBitboards();
+        entry = evaluatePawns(bitboards.pieces(Piece::WHITE_PAWN), bitboards.pieces(Piece::BLACK_PAWN));
+        entry.m_key = key;
+        return entry;
+    }
+
+    void PawnTable::clear()
+    {
+        // the key of a position without pawns is 0, so the slots start out holding that one
+        const PawnEntry empty = evaluatePawns(0, 0);
+        for (size_t i = 0; i <= m_mask; i++)
+            m_entries[i] = empty;
+        resetStats();
+    }
+}
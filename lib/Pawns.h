@@ -0,0 +1,50 @@
+// # Copyright (c) Dylan Leclair
+#pragma once
+
+#include "Bitboard.h"
+#include "Psqt.h"
+
+#include <cstdint>
+#include <memory>
+
+class Board;
+
+namespace eval
+{
+    /// @brief everything about a position that only depends on where the pawns are
+    struct PawnEntry
+    {
+        uint64_t m_key{0};
+        // passed, isolated, doubled and backward pawns, from white's point of view
+        Score m_score;
+        // each side's passed pawns, by PlayerColor
+        Bitboard m_passed[2]{};
+        // the middlegame bonus for the pawns in front of a king on its back two rows, by PlayerColor and the king's file
+        int16_t m_shield[2][8]{};
+    };
+
+    /// @brief works the entry out from scratch
+    PawnEntry evaluatePawns(Bitboard whitePawns, Bitboard blackPawns);
+
+    /// @brief pawn entries by Board::getPawnHash. the pawns change in few moves, so most lookups in a search find
+    /// the structure already worked out. one per searching thread, nothing is shared
+    class PawnTable
+    {
+    public:
+        // rounded down to a power of two entries
+        explicit PawnTable(size_t kilobytes = 1024);
+
+        const PawnEntry &probe(const Board &board);
+        void clear();
+
+        uint64_t probes() const { return m_probes; }
+        uint64_t hits() const { return m_hits; }
+        void resetStats() { m_probes = m_hits = 0; }
+
+    private:
+        std::unique_ptr<PawnEntry[]> m_entries;
+        size_t m_mask{0};
+        uint64_t m_probes{0};
+        uint64_t m_hits{0};
+    };
+}
@@ -0,0 +1,217 @@
+// # Copyright (c) Dylan Leclair
+#include "Perft.h"
+
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace perft
+{
+    namespace
+    {
+        // the depth goes into the key, a position's counts at different depths are different entries
+        uint64_t tableKey(uint64_t hash, int depth)
+        {
+            return hash ^ (static_cast<uint64_t>(depth) * 0x9E3779B97F4A7C15ULL);
+        }
+
+        uint64_t hashedPerft(Board &board, int depth, PerftTable &table, ThreadStats &stats)
+        {
+            if (depth <= 1)
+                return perft(board, depth);
+
+            uint64_t nodes;
+            stats.m_hashProbes++;
+            if (table.probe(board.getHash(), depth, nodes))
+            {
+                stats.m_hashHits++;
+                return nodes;
+            }
+
+            MoveList moves;
+            board.getLegalMoves(moves);
+            nodes = 0;
+            for (const Move &move : moves)
+            {
+                board.move(move);
+                nodes += hashedPerft(board, depth - 1, table, stats);
+                board.undo();
+            }
+            table.store(board.getHash(), depth, nodes);
+            return nodes;
+        }
+
+        // a subtree to count: the two moves that lead to it from the root
+        struct Task
+        {
+            Move m_first;
+            Move m_second;
+        };
+
+        struct TaskQueue
+        {
+            std::mutex m_mutex;
+            std::deque<Task> m_tasks;
+        };
+    }
+
+    PerftTable::PerftTable(size_t megabytes)
+    {
+        size_t entries = 1;
+        while (entries * 2 * sizeof(Entry) <= megabytes * 1024 * 1024)
+            entries *= 2;
+        m_entries.reset(new Entry[entries]());
+        m_mask = entries - 1;
+    }
+
+    bool PerftTable::probe(uint64_t hash, int depth, uint64_t &nodes) const
+    {
+        const uint64_t key = tableKey(hash, depth);
+        const Entry &entry = m_entries[key & m_mask];
+        nodes = entry.m_nodes.load(std::memory_order_relaxed);
+        return (entry.m_check.load(std::memory_order_relaxed) ^ nodes) == key;
+    }
+
+    void PerftTable::store(uint64_t hash, int depth, uint64_t nodes)
+    {
+        // always replace: the most recent subtrees are the likeliest to come up again
+        const uint64_t key = tableKey(hash, depth);
+        Entry &entry = m_entries[key & m_mask];
+        entry.m_check.store(key ^ nodes, std::memory_order_relaxed);
+        entry.m_nodes.store(nodes, std::memory_order_relaxed);
+    }
+
+    uint64_t perft(Board &board, int depth)
+    {
+        if (depth == 0)
+            return 1;
+
+        MoveList moves;
+        board.getLegalMoves(moves);
+
+        // bulk counting: the leaves don't need to be played
+        if (depth == 1)
+            return moves.size();
+
+        uint64_t nodes = 0;
+        for (const Move &move : moves)
+        {
+            board.move(move);
+            nodes += perft(board, depth - 1);
+            board.undo();
+        }
+        return nodes;
+    }
+
+    uint64_t perft(Board &board, int depth, PerftTable &table)
+    {
+        ThreadStats stats;
+        return hashedPerft(board, depth, table, stats);
+    }
+
+    uint64_t divide(Board &board, int depth, std::ostream &out)
+    {
+        MoveList moves;
+        board.getLegalMoves(moves);
+
+        uint64_t total = 0;
+        for (const Move &move : moves)
+        {
+            board.move(move);
+            uint64_t nodes = (depth > 1) ? perft(board, depth - 1) : 1;
+            board.undo();
+
+            out << move.toString() << ": " << nodes << std::endl;
+            total += nodes;
+        }
+        return total;
+    }
+
+    ParallelResult parallelPerft(const Board &board, int depth, int threads, PerftTable *table)
+    {
+        ParallelResult result;
+        result.m_threads.resize(std::max(threads, 1));
+        const int workers = static_cast<int>(result.m_threads.size());
+
+        // too shallow to split
+        Board root(board);
+        if (depth < 3)
+        {
+            ThreadStats &stats = result.m_threads[0];
+            auto start = std::chrono::steady_clock::now();
+            result.m_nodes = stats.m_nodes = table ? hashedPerft(root, depth, *table, stats) : perft(root, depth);
+            stats.m_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            return result;
+        }
+
+        // deal the subtrees out round robin, so every queue gets some of every root move
+        std::vector<TaskQueue> queues(workers);
+        size_t dealt = 0;
+        MoveList firsts;
+        root.getLegalMoves(firsts);
+        for (const Move &first : firsts)
+        {
+            root.move(first);
+            MoveList seconds;
+            root.getLegalMoves(seconds);
+            for (const Move &second : seconds)
+                queues[dealt++ % workers].m_tasks.push_back({first, second});
+            root.undo();
+        }
+
+        auto work = [&](int index) {
+            ThreadStats stats;
+            Board local(board);
+            auto start = std::chrono::steady_clock::now();
+            while (true)
+            {
+                // our own newest task, else another thread's oldest. nothing is queued once the threads are going,
+                // so all the queues empty means all the work is taken
+                Task task;
+                bool found = false;
+                for (int i = 0; i < workers && !found; i++)
+                {
+                    TaskQueue &queue = queues[(index + i) % workers];
+                    std::lock_guard<std::mutex> lock(queue.m_mutex);
+                    if (queue.m_tasks.empty())
+                        continue;
+                    if (i == 0)
+                    {
+                        task = queue.m_tasks.back();
+                        queue.m_tasks.pop_back();
+                    }
+                    else
+                    {
+                        task = queue.m_tasks.front();
+                        queue.m_tasks.pop_front();
+                        stats.m_stolen++;
+                    }
+                    found = true;
+                }
+                if (!found)
+                    break;
+
+                local.move(task.m_first);
+                local.move(task.m_second);
+                stats.m_nodes += table ? hashedPerft(local, depth - 2, *table, stats) : perft(local, depth - 2);
+                local.undo();
+                local.undo();
+                stats.m_tasks++;
+            }
+            stats.m_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            result.m_threads[index] = stats;
+        };
+
+        std::vector<std::thread> pool;
+        for (int i = 1; i < workers; i++)
+            pool.emplace_back(work, i);
+        work(0);
+        for (std::thread &thread : pool)
+            thread.join();
+
+        for (const ThreadStats &stats : result.m_threads)
+            result.m_nodes += stats.m_nodes;
+        return result;
+    }
+}
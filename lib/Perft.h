@@ -0,0 +1,68 @@
+// # Copyright (c) Dylan Leclair
+#pragma once
+
+#include "Board.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+namespace perft
+{
+    /// @brief subtree node counts by position and depth, so a position reached again (by transposition) is counted
+    /// once. shared by every thread without locks, the way search::TranspositionTable is: an entry is the count and
+    /// the key XORed with it, so a slot written by two threads at once fails to verify instead of giving a wrong count.
+    class PerftTable
+    {
+    public:
+        // rounded down to a power of two entries
+        explicit PerftTable(size_t megabytes);
+
+        bool probe(uint64_t hash, int depth, uint64_t &nodes) const;
+        void store(uint64_t hash, int depth, uint64_t nodes);
+
+    private:
+        struct Entry
+        {
+            std::atomic<uint64_t> m_check;
+            std::atomic<uint64_t> m_nodes;
+        };
+
+        std::unique_ptr<Entry[]> m_entries;
+        size_t m_mask{0};
+    };
+
+    /// @brief counts the leaf nodes of the legal move tree below the board's position.
+    /// @param depth plies to search, 0 counts the position itself
+    uint64_t perft(Board &board, int depth);
+    // the same, looking up and storing the counts of subtrees at least two plies deep in the table
+    uint64_t perft(Board &board, int depth, PerftTable &table);
+
+    /// @brief perft split by root move, one "move: nodes" line per move (the format other engines print, for diffing).
+    /// @return the total node count
+    uint64_t divide(Board &board, int depth, std::ostream &out);
+
+    struct ThreadStats
+    {
+        uint64_t m_nodes{0};
+        // subtrees counted, and how many of those were taken from another thread's queue
+        uint64_t m_tasks{0};
+        uint64_t m_stolen{0};
+        uint64_t m_hashProbes{0};
+        uint64_t m_hashHits{0};
+        double m_seconds{0};
+    };
+
+    struct ParallelResult
+    {
+        uint64_t m_nodes{0};
+        std::vector<ThreadStats> m_threads;
+    };
+
+    /// @brief perft on several threads, each with a copy of the board. the work is every subtree below the first
+    /// two plies, dealt out evenly; a thread that runs out takes the oldest task from another's queue, so the
+    /// threads finish together however lopsided the subtrees are. the count is the same as perft's.
+    ParallelResult parallelPerft(const Board &board, int depth, int threads, PerftTable *table = nullptr);
+}
@@ -0,0 +1,464 @@
+// # Copyright (c) Dylan Leclair
+#include "Pgn.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace pgn
+{
+    namespace
+    {
+        const char *START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+        bool isBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+        bool isSpace(char c) { return isBlank(c) || c == '\n'; }
+
+        // the start of the line after the one pos is on
+        size_t nextLine(std::string_view text, size_t pos)
+        {
+            pos = text.find('\n', pos);
+            return pos == std::string_view::npos ? text.size() : pos + 1;
+        }
+
+        // whether the line starting at pos is a tag pair: '[' and then the tag's name. comments like
+        // "[%clk 0:03:00]" that happen to start a line aren't
+        bool isTagLine(std::string_view text, size_t pos)
+        {
+            while (pos < text.size() && isBlank(text[pos]))
+                pos++;
+            return pos + 1 < text.size() && text[pos] == '[' && std::isalnum(static_cast<unsigned char>(text[pos + 1]));
+        }
+
+        // whether the last line before pos with anything on it is a tag pair
+        bool previousLineIsTag(std::string_view text, size_t pos)
+        {
+            while (pos > 0 && isSpace(text[pos - 1]))
+                pos--;
+            if (pos == 0)
+                return false;
+            size_t lineStart = text.rfind('\n', pos - 1);
+            return isTagLine(text, lineStart == std::string_view::npos ? 0 : lineStart + 1);
+        }
+
+        // in white, so the piece's type can be compared whatever its colour
+        Piece toWhite(Piece piece)
+        {
+            return piece > Piece::WHITE_KING ? static_cast<Piece>(piece - 6) : piece;
+        }
+
+        Piece pieceFromLetter(char letter)
+        {
+            switch (letter)
+            {
+            case 'R':
+                return Piece::WHITE_ROOK;
+            case 'N':
+                return Piece::WHITE_KNIGHT;
+            case 'B':
+                return Piece::WHITE_BISHOP;
+            case 'Q':
+                return Piece::WHITE_QUEEN;
+            case 'K':
+                return Piece::WHITE_KING;
+            default:
+                return Piece::EMPTY;
+            }
+        }
+
+        bool isResult(std::string_view token)
+        {
+            return token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*";
+        }
+    }
+
+    std::string_view Game::tag(std::string_view name) const
+    {
+        size_t pos = 0;
+        while ((pos = m_tags.find('[', pos)) != std::string_view::npos)
+        {
+            pos++;
+            size_t nameEnd = pos + name.size();
+            if (m_tags.compare(pos, name.size(), name) != 0 || nameEnd >= m_tags.size() || !isBlank(m_tags[nameEnd]))
+                continue;
+            size_t open = m_tags.find('"', nameEnd);
+            if (open == std::string_view::npos)
+                return {};
+            size_t close = open;
+            do
+            {
+                close = m_tags.find('"', close + 1);
+            } while (close != std::string_view::npos && m_tags[close - 1] == '\\');
+            if (close == std::string_view::npos)
+                return {};
+            return m_tags.substr(open + 1, close - open - 1);
+        }
+        return {};
+    }
+
+    Reader::Reader(std::string_view text, size_t begin, size_t end)
+        : m_text(text),
+          m_pos(std::min(begin, text.size())),
+          m_end(std::min(end, text.size()))
+    {
+    }
+
+    bool Reader::next(Game &game)
+    {
+        while (m_pos < m_text.size() && isSpace(m_text[m_pos]))
+            m_pos++;
+        if (m_pos >= m_end)
+            return false;
+        game.m_offset = m_pos;
+
+        // the tag pairs, blank lines between them allowed
+        size_t tagsBegin = m_pos;
+        size_t tagsEnd = m_pos;
+        while (true)
+        {
+            size_t pos = m_pos;
+            while (pos < m_text.size() && isSpace(m_text[pos]))
+                pos++;
+            if (!isTagLine(m_text, pos))
+                break;
+            m_pos = tagsEnd = nextLine(m_text, pos);
+        }
+        game.m_tags = m_text.substr(tagsBegin, tagsEnd - tagsBegin);
+
+        // then the moves, up to the next game's tags. a comment can span lines, and say anything
+        size_t movesBegin = m_pos;
+        bool inComment = false;
+        for (; m_pos < m_text.size(); m_pos++)
+        {
+            char c = m_text[m_pos];
+            if (inComment)
+                inComment = c != '}';
+            else if (c == '{')
+                inComment = true;
+            else if (c == ';')
+            {
+                // to just before the newline, which may be followed by tags
+                size_t newline = m_text.find('\n', m_pos);
+                m_pos = (newline == std::string_view::npos ? m_text.size() : newline) - 1;
+            }
+            else if (c == '\n' && isTagLine(m_text, m_pos + 1))
+            {
+                m_pos++;
+                break;
+            }
+        }
+        game.m_movetext = m_text.substr(movesBegin, m_pos - movesBegin);
+        return true;
+    }
+
+    size_t nextGame(std::string_view text, size_t offset)
+    {
+        // the first game starts at the beginning, tags or not
+        if (offset == 0)
+            return 0;
+        size_t pos = offset <= text.size() && text[offset - 1] == '\n' ? offset : nextLine(text, offset);
+        // the tags of a game follow the last one's moves: a tag line after one that isn't. this doesn't know about
+        // comments, like the reader does, but a comment with a line in it that looks like a tag pair is rare
+        for (; pos < text.size(); pos = nextLine(text, pos))
+        {
+            if (isTagLine(text, pos) && !previousLineIsTag(text, pos))
+                return pos;
+        }
+        return text.size();
+    }
+
+    Move parseSan(Board &board, std::string_view san)
+    {
+        while (!san.empty() && std::strchr("+#!?", san.back()))
+            san.remove_suffix(1);
+        if (san.size() < 2)
+            return Move();
+
+        const Bitboards &bitboards = board.getBitboards();
+        const PlayerColor us = board.getPlayerToMove();
+        auto ours = [&bitboards, us](Piece piece) { return bitboards.pieces(static_cast<Piece>(piece + 6 * us)); };
+        MoveList moves;
+
+        // castling, also written with zeroes
+        if (san == "O-O" || san == "0-0" || san == "O-O-O" || san == "0-0-0")
+        {
+            board.getLegalMovesFrom(moves, ours(Piece::WHITE_KING));
+            uint8_t flag = san.size() == 3 ? Move::Flag::KINGSIDE_CASTLE : Move::Flag::QUEENSIDE_CASTLE;
+            auto move = std::find_if(moves.begin(), moves.end(), [flag](const Move &move) { return move.flags() == flag; });
+            return move == moves.end() ? Move() : *move;
+        }
+
+        Piece piece = pieceFromLetter(san[0]);
+        size_t i = 1;
+        if (piece == Piece::EMPTY)
+        {
+            piece = Piece::WHITE_PAWN;
+            i = 0;
+        }
+
+        // "e8=Q", or sometimes just "e8Q"
+        Piece promotion = Piece::EMPTY;
+        if (piece == Piece::WHITE_PAWN && (promotion = pieceFromLetter(san.back())) != Piece::EMPTY)
+        {
+            san.remove_suffix(1);
+            if (!san.empty() && san.back() == '=')
+                san.remove_suffix(1);
+        }
+
+        if (san.size() < i + 2)
+            return Move();
+        char file = san[san.size() - 2];
+        char rank = san[san.size() - 1];
+        if (file < 'a' || file > 'h' || rank < '1' || rank > '8')
+            return Move();
+        int dest = ('8' - rank) * 8 + (file - 'a');
+
+        // between the piece and the destination: which file and/or rank it comes from, and whether it captures
+        int fromCol = -1, fromRow = -1;
+        for (; i < san.size() - 2; i++)
+        {
+            char c = san[i];
+            if (c >= 'a' && c <= 'h')
+                fromCol = c - 'a';
+            else if (c >= '1' && c <= '8')
+                fromRow = '8' - c;
+            else if (c != 'x' && c != ':' && c != '-')
+                return Move();
+        }
+
+        // only the moves of pieces of the right kind, and (but for pawns, which don't capture where they push)
+        // of the ones that see the destination: usually that's one piece, so one piece's moves
+        Bitboard from = ours(piece);
+        if (piece != Piece::WHITE_PAWN)
+            from &= board.attackersTo(dest, bitboards.occupied());
+        board.getLegalMovesFrom(moves, from);
+
+        Move found;
+        for (const Move &move : moves)
+        {
+            if (move.dest() != dest || move.promotion() != promotion || toWhite(bitboards.at(move.start())) != piece)
+                continue;
+            if ((fromCol >= 0 && move.start() % 8 != fromCol) || (fromRow >= 0 && move.start() / 8 != fromRow))
+                continue;
+            // ambiguous
+            if (!found.isNull())
+                return Move();
+            found = move;
+        }
+        return found;
+    }
+
+    std::string toSan(Board &board, Move move)
+    {
+        std::string san;
+        if (move.isCastling())
+            san = move.flags() == Move::Flag::KINGSIDE_CASTLE ? "O-O" : "O-O-O";
+        else
+        {
+            const Bitboards &bitboards = board.getBitboards();
+            Piece piece = toWhite(bitboards.at(move.start()));
+            if (piece == Piece::WHITE_PAWN)
+            {
+                if (move.isCapture())
+                    san += static_cast<char>('a' + move.start() % 8);
+            }
+            else
+            {
+                san += " PRNBQK"[piece];
+
+                // name the start file if that tells it apart from the other pieces of its kind that can go there,
+                // else the rank, else both
+                MoveList moves;
+                board.getLegalMoves(moves);
+                bool ambiguous = false, sameCol = false, sameRow = false;
+                for (const Move &other : moves)
+                {
+                    if (other.dest() != move.dest() || other.start() == move.start() || toWhite(bitboards.at(other.start())) != piece)
+                        continue;
+                    ambiguous = true;
+                    sameCol |= other.start() % 8 == move.start() % 8;
+                    sameRow |= other.start() / 8 == move.start() / 8;
+                }
+                if (ambiguous && (!sameCol || sameRow))
+                    san += static_cast<char>('a' + move.start() % 8);
+                if (ambiguous && sameCol)
+                    san += static_cast<char>('8' - move.start() / 8);
+            }
+            if (move.isCapture())
+                san += 'x';
+            san += static_cast<char>('a' + move.dest() % 8);
+            san += static_cast<char>('8' - move.dest() / 8);
+            if (move.isPromotion())
+            {
+                san += '=';
+                san += "NBRQ"[move.flags() & 3];
+            }
+        }
+
+        board.move(move);
+        if (board.isInCheck(board.getPlayerToMove()))
+        {
+            MoveList replies;
+            board.getLegalMoves(replies);
+            san += replies.empty() ? '#' : '+';
+        }
+        board.undo();
+        return san;
+    }
+
+    int replay(const Game &game, Board &board, std::string *error)
+    {
+        auto fail = [error](std::string reason) {
+            if (error)
+                *error = std::move(reason);
+            return -1;
+        };
+
+        std::string_view fen = game.tag("FEN");
+        if (!board.setFen(fen.empty() ? START_FEN : fen))
+            return fail("invalid FEN \"" + std::string(fen) + "\"");
+
+        const std::string_view text = game.m_movetext;
+        int played = 0;
+        size_t pos = 0;
+        while (pos < text.size())
+        {
+            char c = text[pos];
+            if (isSpace(c))
+                pos++;
+            else if (c == '{')
+            {
+                pos = text.find('}', pos);
+                if (pos == std::string_view::npos)
+                    return fail("unterminated comment");
+                pos++;
+            }
+            // a comment to the end of the line, or an escaped line
+            else if (c == ';' || (c == '%' && (pos == 0 || text[pos - 1] == '\n')))
+                pos = nextLine(text, pos);
+            // a variation, which may hold variations and comments of its own
+            else if (c == '(')
+            {
+                int depth = 0;
+                for (; pos < text.size(); pos++)
+                {
+                    if (text[pos] == '{')
+                    {
+                        pos = text.find('}', pos);
+                        if (pos == std::string_view::npos)
+                            break;
+                    }
+                    else if (text[pos] == '(')
+                        depth++;
+                    else if (text[pos] == ')' && --depth == 0)
+                        break;
+                }
+                if (pos >= text.size())
+                    return fail("unterminated variation");
+                pos++;
+            }
+            // numeric annotation glyph
+            else if (c == '$')
+            {
+                pos++;
+                while (pos < text.size() && std::isdigit(static_cast<unsigned char>(text[pos])))
+                    pos++;
+            }
+            else
+            {
+                size_t end = pos;
+                while (end < text.size() && !isSpace(text[end]) && !std::strchr("{}();$", text[end]))
+                    end++;
+                // a closing bracket with nothing open (or a NUL byte, which strchr finds too): stuck on it otherwise
+                if (end == pos)
+                    return fail("unexpected '" + std::string(1, c) + "'");
+                std::string_view token = text.substr(pos, end - pos);
+                pos = end;
+                if (isResult(token))
+                    break;
+
+                // move numbers, maybe run together with the move ("12.e4", "12...Nf6")
+                size_t digits = 0;
+                while (digits < token.size() && std::isdigit(static_cast<unsigned char>(token[digits])))
+                    digits++;
+                size_t dots = digits;
+                while (dots < token.size() && token[dots] == '.')
+                    dots++;
+                if (digits > 0 && dots == digits)
+                    return fail("unexpected \"" + std::string(token) + "\"");
+                token.remove_prefix(dots);
+                if (token.empty())
+                    continue;
+
+                Move move = parseSan(board, token);
+                if (move.isNull())
+                {
+                    return fail(std::to_string(board.getFullmoveNumber()) +
+                                (board.getPlayerToMove() == PlayerColor::White ? ". " : "... ") +
+                                std::string(token) + " is illegal or ambiguous");
+                }
+                board.move(move);
+                played++;
+            }
+        }
+        return played;
+    }
+
+    Stats replayAll(std::string_view text, int threads,
+                    const std::function<void(const Game &, const std::string &)> &onRejected)
+    {
+        threads = std::max(threads, 1);
+        // pieces of at least 64kB (a few dozen games), plenty of them for every thread
+        const size_t pieces = std::clamp<size_t>(text.size() / 65536, 1, static_cast<size_t>(threads) * 16);
+        std::vector<size_t> starts;
+        for (size_t i = 0; i < pieces; i++)
+            starts.push_back(nextGame(text, text.size() * i / pieces));
+        starts.push_back(text.size());
+
+        std::atomic<size_t> nextPiece{0};
+        std::mutex mutex;
+        Stats total;
+        auto work = [&]() {
+            Board board;
+            Game game;
+            std::string error;
+            Stats stats;
+            for (size_t piece; (piece = nextPiece++) < pieces;)
+            {
+                Reader reader(text, starts[piece], starts[piece + 1]);
+                while (reader.next(game))
+                {
+                    stats.m_games++;
+                    int played = replay(game, board, &error);
+                    if (played >= 0)
+                    {
+                        stats.m_moves += played;
+                        continue;
+                    }
+                    stats.m_rejected++;
+                    if (onRejected)
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        onRejected(game, error);
+                    }
+                }
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            total.m_games += stats.m_games;
+            total.m_rejected += stats.m_rejected;
+            total.m_moves += stats.m_moves;
+        };
+
+        std::vector<std::thread> workers;
+        for (int i = 1; i < threads; i++)
+            workers.emplace_back(work);
+        work();
+        for (std::thread &worker : workers)
+            worker.join();
+        return total;
+    }
+}
@@ -0,0 +1,78 @@
+// # Copyright (c) Dylan Leclair
+#pragma once
+
+#include "Board.h"
+#include "Move.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+/// @brief reading games in Portable Game Notation, in bulk.
+///
+/// games are read straight out of the text (usually a MappedFile) as views, nothing is copied or allocated per
+/// game. moves in standard algebraic notation (SAN) are resolved against the legal moves of the position they're
+/// played in, so replaying a game also checks it: a move that's illegal, ambiguous or unreadable rejects the game.
+namespace pgn
+{
+    /// @brief one game: the tag pair section and the movetext after it, as they are in the text.
+    struct Game
+    {
+        std::string_view m_tags;
+        std::string_view m_movetext;
+        // where the game starts in the text, for error messages
+        size_t m_offset{0};
+
+        /// @brief the value of a tag (e.g. "White" for [White "Carlsen, Magnus"]), empty if there's no such tag.
+        /// escaped quotes are left as they are.
+        std::string_view tag(std::string_view name) const;
+    };
+
+    /// @brief splits the text into games. a game is its tag lines followed by everything up to the next tag line
+    /// outside a {comment}, so games without any movetext (or without tags, at the very start) are still games.
+    class Reader
+    {
+    public:
+        // reads the games that start in [begin, end) of the text. they may run on past end
+        explicit Reader(std::string_view text, size_t begin = 0, size_t end = std::string_view::npos);
+
+        /// @brief the next game, false once there are none left
+        bool next(Game &game);
+
+    private:
+        std::string_view m_text;
+        size_t m_pos;
+        size_t m_end;
+    };
+
+    /// @brief where the first game starting at or after offset begins, or the text's size if none does.
+    /// used to cut a text into pieces that can be read independently.
+    size_t nextGame(std::string_view text, size_t offset);
+
+    /// @brief the legal move a SAN move ("e4", "Nbd7", "exd8=Q+", "O-O") stands for in the board's position.
+    /// check and annotation marks (+ # ! ?) are ignored. the null move if it's illegal, ambiguous or unreadable.
+    Move parseSan(Board &board, std::string_view san);
+
+    /// @brief the SAN of a legal move in the board's position, with just enough disambiguation and + or #.
+    std::string toSan(Board &board, Move move);
+
+    /// @brief sets the board to the game's starting position (the FEN tag if there is one) and plays its moves.
+    /// comments, variations, numeric annotation glyphs and move numbers are skipped.
+    /// @return the number of moves played, or -1 if the game is invalid (error says why, if given)
+    int replay(const Game &game, Board &board, std::string *error = nullptr);
+
+    struct Stats
+    {
+        uint64_t m_games{0};
+        uint64_t m_rejected{0};
+        uint64_t m_moves{0};
+    };
+
+    /// @brief replays every game of the text on the given number of threads, each with a board of its own.
+    /// the text is cut into many more pieces than there are threads, which take the next piece when they're done
+    /// with one, so a few long games can't hold up the rest. onRejected (if given) is called for every invalid game,
+    /// one call at a time, in no particular order.
+    Stats replayAll(std::string_view text, int threads,
+                    const std::function<void(const Game &, const std::string &)> &onRejected = nullptr);
+}
@@ -1,6 +1,8 @@
 // # Copyright (c) Dylan Leclair
 #pragma once
 
+#include "PlayerColor.h"
+
 enum Piece
 {
     EMPTY,
@@ -20,6 +22,15 @@ enum Piece
     SQUARE_WHITE
 };
 
+static inline PlayerColor getPieceColor(Piece p)
+{
+    if (Piece::WHITE_PAWN <= p && p <= Piece::WHITE_KING)
+        return PlayerColor::White;
+    if (Piece::BLACK_PAWN <= p && p <= Piece::BLACK_KING)
+        return PlayerColor::Black;
+    return PlayerColor::None;
+}
+
 static const char getChar(Piece &p)
 {
     switch (p)
@@ -0,0 +1,375 @@
+// # Copyright (c) Dylan Leclair
+#include "Search.h"
+#include "Evaluate.h"
+
+#include <algorithm>
+
+namespace search
+{
+    Search::Search()
+        : Search(nullptr, 0)
+    {
+    }
+
+    Search::Search(TranspositionTable &table, int threadIndex)
+        : Search(&table, threadIndex)
+    {
+    }
+
+    Search::Search(TranspositionTable *table, int threadIndex)
+        : m_ownTable(table ? nullptr : new TranspositionTable()),
+          m_table(table ? table : m_ownTable.get()),
+          m_threadIndex(threadIndex),
+          m_pv(MAX_PLY + 1, std::vector<Move>(MAX_PLY + 1)),
+          m_pvLength(MAX_PLY + 1, 0)
+    {
+    }
+
+    Result Search::run(Board &board, const Limits &limits)
+    {
+        m_stopped = false;
+        m_ponderhit = false;
+        return iterate(board, limits);
+    }
+
+    Result Search::iterate(Board &board, const Limits &limits)
+    {
+        m_limits = limits;
+        m_start = std::chrono::steady_clock::now();
+        m_pondering = limits.m_ponder;
+        m_nodes = 0;
+        m_previousPv.clear();
+        for (auto &killers : m_killers)
+            killers[0] = killers[1] = Move();
+        m_history.clear();
+        m_pawnTable.resetStats();
+        if (m_ownTable)
+            m_table->newSearch();
+
+        Result result;
+        MoveList rootMoves;
+        board.getLegalMoves(rootMoves);
+        if (rootMoves.empty())
+        {
+            result.m_score = board.isInCheck(board.getPlayerToMove()) ? -MATE_SCORE : 0;
+            return result;
+        }
+        // always have something to play, even if the first iteration gets cut short
+        result.m_bestMove = rootMoves[0];
+
+        int maxDepth = std::min(limits.m_depth > 0 ? limits.m_depth : MAX_PLY, MAX_PLY);
+        for (int depth = 1; depth <= maxDepth; depth++)
+        {
+            if (skipIteration(depth))
+                continue;
+
+            int score = negamax(board, depth, -INFINITE_SCORE, INFINITE_SCORE, 0, false);
+            if (m_stopped)
+                break;
+
+            result.m_score = score;
+            result.m_depth = depth;
+            result.m_pv.assign(m_pv[0].begin(), m_pv[0].begin() + m_pvLength[0]);
+            result.m_bestMove = result.m_pv.empty() ? result.m_bestMove : result.m_pv[0];
+            result.m_nodes = m_nodes;
+            result.m_pawnProbes = m_pawnTable.probes();
+            result.m_pawnHits = m_pawnTable.hits();
+            m_previousPv = result.m_pv;
+            if (m_onIteration)
+                m_onIteration(result);
+
+            // a forced mate won't get any shorter by looking deeper
+            if (std::abs(score) >= MATE_BOUND)
+                break;
+            // each iteration takes about as long as all the ones before it together, or longer,
+            // so past half the time the next one would most likely overrun it
+            checkPonderhit();
+            if (m_limits.m_softTimeMs && !m_pondering && 2 * elapsedMs() >= m_limits.m_softTimeMs)
+                break;
+        }
+        result.m_nodes = m_nodes;
+        result.m_pawnProbes = m_pawnTable.probes();
+        result.m_pawnHits = m_pawnTable.hits();
+        return result;
+    }
+
+    bool Search::skipIteration(int depth) const
+    {
+        // helpers skip depths in different patterns (in blocks of 1 to 4, at different offsets),
+        // so at any moment the threads are spread over the next few depths instead of all racing on the same one
+        static const int skipSize[20] = {1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+        static const int skipPhase[20] = {0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7};
+        if (m_threadIndex == 0)
+            return false;
+        int i = (m_threadIndex - 1) % 20;
+        return ((depth + skipPhase[i]) / skipSize[i]) % 2 != 0;
+    }
+
+    bool Search::shouldStop()
+    {
+        if (m_limits.m_nodes && m_nodes >= m_limits.m_nodes)
+            m_stopped = true;
+
+        // the clock is only read every so often, it's comparatively slow
+        if ((m_nodes & 1023) == 0)
+        {
+            checkPonderhit();
+            if (m_limits.m_timeMs && !m_pondering && elapsedMs() >= m_limits.m_timeMs)
+                m_stopped = true;
+        }
+        return m_stopped;
+    }
+
+    void Search::checkPonderhit()
+    {
+        if (m_ponderhit.exchange(false, std::memory_order_relaxed))
+        {
+            m_pondering = false;
+            m_start = std::chrono::steady_clock::now();
+        }
+    }
+
+    int Search::elapsedMs() const
+    {
+        return static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - m_start).count());
+    }
+
+    Limits clockLimits(int timeLeftMs, int incrementMs, int movesToGo)
+    {
+        // for the time it takes the move to get to the GUI, and any delay in noticing the limit
+        const int overheadMs = 30;
+        // a guess at how many moves are left when there's no time control coming
+        const int suddenDeathMoves = 30;
+
+        Limits limits;
+        int available = std::max(timeLeftMs - overheadMs, 1);
+        int moves = movesToGo > 0 ? std::min(movesToGo, suddenDeathMoves) : suddenDeathMoves;
+        int target = available / moves + incrementMs * 3 / 4;
+        // whatever the share, never plan to use more than most of what's left
+        int ceiling = std::max(available * 4 / 5, 1);
+        limits.m_softTimeMs = std::clamp(target, 1, ceiling);
+        limits.m_timeMs = std::clamp(target * 3, 1, ceiling);
+        return limits;
+    }
+
+    void Search::updateQuietStats(PlayerColor side, Move move, const MoveList &triedQuiets, int depth, int ply)
+    {
+        if (m_killers[ply][0] != move)
+        {
+            m_killers[ply][1] = m_killers[ply][0];
+            m_killers[ply][0] = move;
+        }
+
+        int bonus = depth * depth;
+        m_history.update(side, move, bonus);
+        for (const Move &tried : triedQuiets)
+            m_history.update(side, tried, -bonus);
+    }
+
+    int Search::quiescence(Board &board, int alpha, int beta, int ply)
+    {
+        m_pvLength[ply] = 0;
+        m_nodes.store(m_nodes.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (shouldStop())
+            return 0;
+        if (board.isDraw(ply))
+            return 0;
+        if (ply >= MAX_PLY)
+            return eval::evaluate(board, &m_pawnTable);
+
+        // out of check the side to move can "stand pat": it doesn't have to take anything,
+        // so the static evaluation is already a lower bound
+        const bool inCheck = board.isInCheck(board.getPlayerToMove());
+        int bestScore = -INFINITE_SCORE;
+        if (!inCheck)
+        {
+            bestScore = eval::evaluate(board, &m_pawnTable);
+            if (bestScore >= beta)
+                return bestScore;
+            alpha = std::max(alpha, bestScore);
+        }
+
+        MoveList moves;
+        int scores[MoveList::CAPACITY];
+        if (inCheck)
+        {
+            board.getLegalMoves(moves);
+            if (moves.empty())
+                return -MATE_SCORE + ply;
+            // evasions: captures by how much they win, the rest after them
+            for (size_t i = 0; i < moves.size(); i++)
+                scores[i] = moves[i].isCapture() || moves[i].isPromotion() ? eval::see(board, moves[i]) : -INFINITE_SCORE;
+        }
+        else
+        {
+            // captures that lose material are pruned: they'd have to be refuted anyway, and standing pat
+            // or a better capture already covers the side to move
+            board.getLegalCaptures(moves);
+            size_t kept = 0;
+            for (size_t i = 0; i < moves.size(); i++)
+            {
+                int see = eval::see(board, moves[i]);
+                if (see < 0)
+                    continue;
+                scores[kept] = see;
+                moves[kept++] = moves[i];
+            }
+            moves.erase(moves.begin() + kept);
+        }
+
+        // best exchanges first
+        for (size_t i = 1; i < moves.size(); i++)
+        {
+            Move move = moves[i];
+            int score = scores[i];
+            size_t j = i;
+            for (; j > 0 && scores[j - 1] < score; j--)
+            {
+                moves[j] = moves[j - 1];
+                scores[j] = scores[j - 1];
+            }
+            moves[j] = move;
+            scores[j] = score;
+        }
+
+        for (const Move &move : moves)
+        {
+            board.move(move);
+            int score = -quiescence(board, -beta, -alpha, ply + 1);
+            board.undo();
+            if (m_stopped)
+                return 0;
+
+            if (score > bestScore)
+            {
+                bestScore = score;
+                if (score > alpha)
+                    alpha = score;
+                if (alpha >= beta)
+                    break;
+            }
+        }
+        return bestScore;
+    }
+
+    int Search::negamax(Board &board, int depth, int alpha, int beta, int ply, bool allowNull)
+    {
+        if (depth <= 0)
+            return quiescence(board, alpha, beta, ply);
+
+        m_pvLength[ply] = 0;
+        m_nodes.store(m_nodes.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (shouldStop())
+            return 0;
+        if (ply > 0)
+        {
+            if (board.isDraw(ply))
+                return 0;
+            // a move back to an earlier position is there for the taking, so the side to move can count on a draw
+            if (alpha < 0 && board.hasUpcomingRepetition(ply))
+            {
+                alpha = 0;
+                if (alpha >= beta)
+                    return alpha;
+            }
+        }
+
+        if (ply >= MAX_PLY)
+            return eval::evaluate(board, &m_pawnTable);
+
+        const PlayerColor us = board.getPlayerToMove();
+        const bool inCheck = board.isInCheck(us);
+        const bool isPvNode = beta - alpha > 1;
+        const int originalAlpha = alpha;
+
+        // a deep enough result for this position from elsewhere in the tree (or an earlier search) may settle it.
+        // not at PV nodes, so the principal variation stays complete
+        const uint64_t key = board.getHash();
+        Move hashMove;
+        TTEntry entry;
+        if (m_table->probe(key, entry))
+        {
+            hashMove = entry.m_move;
+            int score = scoreFromTable(entry.m_score, ply);
+            if (!isPvNode && entry.m_depth >= depth &&
+                (entry.m_bound == BOUND_EXACT ||
+                 (entry.m_bound == BOUND_LOWER && score >= beta) ||
+                 (entry.m_bound == BOUND_UPPER && score <= alpha)))
+                return score;
+        }
+
+        // null move pruning: if passing the turn still fails high, a real move almost certainly would too.
+        // not in check (passing would be illegal) and not with only pawns left (zugzwang is common)
+        if (allowNull && !isPvNode && !inCheck && depth >= 3 && eval::hasNonPawnMaterial(board) && eval::evaluate(board, &m_pawnTable) >= beta)
+        {
+            int reduction = 2 + depth / 4;
+            board.makeNullMove();
+            int score = -negamax(board, depth - 1 - reduction, -beta, -beta + 1, ply + 1, false);
+            board.undo();
+            if (m_stopped)
+                return 0;
+            if (score >= beta)
+                return score >= MATE_BOUND ? beta : score;
+        }
+
+        // without a move from the table, the previous iteration's move at this ply is the best guess
+        if (hashMove.isNull() && ply < static_cast<int>(m_previousPv.size()))
+            hashMove = m_previousPv[ply];
+        MovePicker picker(board, hashMove, m_killers[ply], m_history);
+
+        int bestScore = -INFINITE_SCORE;
+        Move bestMove;
+        int movesSearched = 0;
+        MoveList triedQuiets;
+        for (Move move = picker.next(); !move.isNull(); move = picker.next())
+        {
+            board.move(move);
+            int score;
+            if (movesSearched++ == 0)
+            {
+                score = -negamax(board, depth - 1, -beta, -alpha, ply + 1, true);
+            }
+            else
+            {
+                // principal variation search: prove the move is worse with a null window,
+                // and only search it properly if that fails
+                score = -negamax(board, depth - 1, -alpha - 1, -alpha, ply + 1, true);
+                if (score > alpha && score < beta)
+                    score = -negamax(board, depth - 1, -beta, -alpha, ply + 1, true);
+            }
+            board.undo();
+
+            if (m_stopped)
+                return 0;
+
+            if (score > bestScore)
+            {
+                bestScore = score;
+                if (score > alpha)
+                {
+                    bestMove = move;
+                    alpha = score;
+                    // this move followed by the child's line
+                    m_pv[ply][0] = move;
+                    std::copy(m_pv[ply + 1].begin(), m_pv[ply + 1].begin() + m_pvLength[ply + 1], m_pv[ply].begin() + 1);
+                    m_pvLength[ply] = m_pvLength[ply + 1] + 1;
+                }
+                if (alpha >= beta)
+                {
+                    if (!move.isCapture() && !move.isPromotion())
+                        updateQuietStats(us, move, triedQuiets, depth, ply);
+                    break;
+                }
+            }
+            if (!move.isCapture() && !move.isPromotion())
+                triedQuiets.push_back(move);
+        }
+        if (movesSearched == 0)
+            return inCheck ? -MATE_SCORE + ply : 0;
+
+        // a fail low has no meaningful best move, the table keeps whatever it had
+        Bound bound = bestScore >= beta ? BOUND_LOWER : bestScore > originalAlpha ? BOUND_EXACT : BOUND_UPPER;
+        m_table->store(key, bestMove, scoreToTable(bestScore, ply), depth, bound);
+        return bestScore;
+    }
+}
@@ -0,0 +1,130 @@
+// # Copyright (c) Dylan Leclair
+#pragma once
+
+#include "Board.h"
+#include "Move.h"
+#include "MovePicker.h"
+#include "Pawns.h"
+#include "TranspositionTable.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace search
+{
+    const int MAX_PLY = 64;
+    const int INFINITE_SCORE = 32001;
+    const int MATE_SCORE = 32000;
+    // anything above this is a forced mate, scored by distance so shorter mates are preferred
+    const int MATE_BOUND = MATE_SCORE - MAX_PLY;
+
+    /// @brief when to stop searching. 0 means no limit, searching stops at whichever limit is hit first.
+    struct Limits
+    {
+        int m_depth{MAX_PLY};
+        uint64_t m_nodes{0};
+        // hard limit: the search stops in the middle of an iteration
+        int m_timeMs{0};
+        // the time the move should take: no new iteration is started once it probably wouldn't finish within it
+        int m_softTimeMs{0};
+        // searching on the opponent's time: the clock doesn't run until ponderhit()
+        bool m_ponder{false};
+    };
+
+    /// @brief time limits for one move, from the time left on the clock: an even share of it over the moves to go
+    /// (or a guess at how many are left in sudden death) plus most of the increment, with a hard limit a few times
+    /// that. always leaves some time on the clock for the moves after.
+    Limits clockLimits(int timeLeftMs, int incrementMs, int movesToGo);
+
+    struct Result
+    {
+        Move m_bestMove; // the null move if there are no legal moves
+        int m_score{0};  // centipawns from the side to move's point of view
+        int m_depth{0};  // last fully completed iteration
+        uint64_t m_nodes{0};
+        // pawn structure lookups in the evaluation, and how many found the position's pawns already worked out
+        uint64_t m_pawnProbes{0};
+        uint64_t m_pawnHits{0};
+        std::vector<Move> m_pv;
+    };
+
+    /// @brief negamax alpha-beta with iterative deepening, principal variation search, null move pruning, a
+    /// transposition table and a quiescence search of captures at the leaves. moves come from a MovePicker,
+    /// ordered by the hash move, captures, killer moves and history. the board is searched in place with move/undo and is back in its original position afterwards.
+    class Search
+    {
+    public:
+        /// @brief with a table of its own, of the default size
+        Search();
+        /// @brief with a table that's shared with other searches (which must outlive this one).
+        /// whoever owns a shared table calls newSearch() on it, run() only does that for a table of its own.
+        /// threadIndex > 0 makes this a Lazy SMP helper, which skips some iterations so threads spread over depths.
+        explicit Search(TranspositionTable &table, int threadIndex = 0);
+
+        Result run(Board &board, const Limits &limits);
+
+        /// @brief asks a running search to stop, it returns the last completed iteration. safe from any thread.
+        void stop() { m_stopped = true; }
+
+        /// @brief nodes searched so far, can be read (roughly) from another thread while searching
+        uint64_t nodes() const { return m_nodes.load(std::memory_order_relaxed); }
+
+        /// @brief the opponent played the move a pondering search was started on: the time limits start counting now.
+        /// safe from any thread.
+        void ponderhit() { m_ponderhit = true; }
+
+        /// @brief called by the searching thread after every completed iteration (e.g. to print UCI info lines)
+        void onIteration(std::function<void(const Result &)> callback) { m_onIteration = std::move(callback); }
+
+    private:
+        friend class ThreadedSearch;
+
+        Search(TranspositionTable *table, int threadIndex);
+
+        // run() without clearing the stop and ponderhit flags first, so a stop() from before the search started isn't lost
+        Result iterate(Board &board, const Limits &limits);
+
+        int negamax(Board &board, int depth, int alpha, int beta, int ply, bool allowNull);
+        // searches captures (all moves in check) until the position is quiet, so the evaluation isn't taken
+        // in the middle of an exchange
+        int quiescence(Board &board, int alpha, int beta, int ply);
+        // a quiet move caused a cutoff: remember it as a killer for the ply, and reward it (and penalise the quiet
+        // moves tried before it) in the history
+        void updateQuietStats(PlayerColor side, Move move, const MoveList &triedQuiets, int depth, int ply);
+        bool shouldStop();
+        // starts the clock if ponderhit() was called since the last look
+        void checkPonderhit();
+        int elapsedMs() const;
+        bool skipIteration(int depth) const;
+
+        std::unique_ptr<TranspositionTable> m_ownTable;
+        TranspositionTable *m_table;
+        int m_threadIndex;
+
+        Limits m_limits;
+        std::chrono::steady_clock::time_point m_start;
+        std::atomic<bool> m_stopped{false};
+        std::atomic<bool> m_ponderhit{false};
+        // only read and written by the searching thread
+        bool m_pondering{false};
+        std::function<void(const Result &)> m_onIteration;
+        // only ever written by the searching thread, atomic so other threads can read it
+        std::atomic<uint64_t> m_nodes{0};
+
+        // triangular principal variation table: m_pv[ply] is the best line found from ply onwards
+        std::vector<std::vector<Move>> m_pv;
+        std::vector<int> m_pvLength;
+        // the previous iteration's line, searched first
+        std::vector<Move> m_previousPv;
+
+        // the two most recent quiet moves that caused a cutoff at each ply
+        Move m_killers[MAX_PLY + 1][2];
+        History m_history;
+        // kept from one search to the next, the pawn structures seldom change much between moves
+        eval::PawnTable m_pawnTable;
+    };
+}
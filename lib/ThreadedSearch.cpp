@@ -0,0 +1,103 @@
+// # Copyright (c) Dylan Leclair
+#include "ThreadedSearch.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace search
+{
+    ThreadedSearch::ThreadedSearch(size_t hashMb, int threads)
+        : m_table(hashMb)
+    {
+        setThreads(threads);
+    }
+
+    ThreadedSearch::~ThreadedSearch()
+    {
+        stop();
+        wait();
+    }
+
+    void ThreadedSearch::setThreads(int threads)
+    {
+        threads = std::max(threads, 1);
+        m_searches.resize(std::min(static_cast<size_t>(threads), m_searches.size()));
+        while (static_cast<int>(m_searches.size()) < threads)
+            m_searches.emplace_back(new Search(m_table, static_cast<int>(m_searches.size())));
+    }
+
+    Result ThreadedSearch::run(const Board &board, const Limits &limits)
+    {
+        start(board, limits);
+        return wait();
+    }
+
+    void ThreadedSearch::start(const Board &board, const Limits &limits, std::function<void(const Result &)> onDone)
+    {
+        wait();
+        m_table.newSearch();
+        // cleared here rather than in each thread, so stopping a thread that hasn't started yet still works
+        for (auto &search : m_searches)
+        {
+            search->m_stopped = false;
+            search->m_ponderhit = false;
+        }
+
+        m_thread = std::thread([this, board = Board(board), limits, onDone = std::move(onDone)]() {
+            m_result = search(board, limits);
+            if (onDone)
+                onDone(m_result);
+        });
+    }
+
+    Result ThreadedSearch::wait()
+    {
+        if (m_thread.joinable())
+            m_thread.join();
+        return m_result;
+    }
+
+    uint64_t ThreadedSearch::nodes() const
+    {
+        uint64_t total = 0;
+        for (const auto &search : m_searches)
+            total += search->nodes();
+        return total;
+    }
+
+    Result ThreadedSearch::search(const Board &board, const Limits &limits)
+    {
+        // helpers just keep going until the main thread is done
+        Limits helperLimits;
+        std::vector<std::thread> helpers;
+        for (size_t i = 1; i < m_searches.size(); i++)
+        {
+            helpers.emplace_back([this, i, &board, &helperLimits]() {
+                Board copy(board);
+                m_searches[i]->iterate(copy, helperLimits);
+            });
+        }
+
+        Board copy(board);
+        Result result = m_searches[0]->iterate(copy, limits);
+
+        for (size_t i = 1; i < m_searches.size(); i++)
+            m_searches[i]->stop();
+        for (std::thread &helper : helpers)
+            helper.join();
+
+        for (size_t i = 1; i < m_searches.size(); i++)
+        {
+            result.m_nodes += m_searches[i]->nodes();
+            result.m_pawnProbes += m_searches[i]->m_pawnTable.probes();
+            result.m_pawnHits += m_searches[i]->m_pawnTable.hits();
+        }
+        return result;
+    }
+
+    void ThreadedSearch::stop()
+    {
+        for (auto &search : m_searches)
+            search->stop();
+    }
+}
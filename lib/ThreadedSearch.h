@@ -0,0 +1,62 @@
+// # Copyright (c) Dylan Leclair
+#pragma once
+
+#include "Board.h"
+#include "Search.h"
+#include "TranspositionTable.h"
+
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace search
+{
+    /// @brief Lazy SMP: the same position searched by several threads at once, which only share the transposition table.
+    /// each thread has its own copy of the board. the helpers skip some depths so they fill the table ahead of the
+    /// main thread, and the main thread's result is the answer. with one thread this is just a Search.
+    class ThreadedSearch
+    {
+    public:
+        explicit ThreadedSearch(size_t hashMb = DEFAULT_HASH_MB, int threads = 1);
+        // stops and waits for any search still running
+        ~ThreadedSearch();
+
+        /// @brief not while searching
+        void setThreads(int threads);
+        int threads() const { return static_cast<int>(m_searches.size()); }
+
+        /// @brief not while searching
+        TranspositionTable &table() { return m_table; }
+
+        /// @brief the limits apply to the main thread, the helpers stop when it does. the board is left unchanged.
+        /// the result's node count is the total over all threads.
+        Result run(const Board &board, const Limits &limits);
+
+        /// @brief run() in the background: returns straight away, and the search calls onDone with the result from
+        /// its own thread when it finishes. stop() and ponderhit() count from the moment this is called.
+        void start(const Board &board, const Limits &limits, std::function<void(const Result &)> onDone = nullptr);
+        /// @brief waits for a search from start() to finish (including its onDone), and returns its result
+        Result wait();
+
+        /// @brief stops every thread, the search returns the main thread's last completed iteration. safe from any thread.
+        void stop();
+        /// @brief see Search::ponderhit. safe from any thread.
+        void ponderhit() { m_searches[0]->ponderhit(); }
+
+        /// @brief nodes searched by all threads so far, safe from any thread
+        uint64_t nodes() const;
+        /// @brief see Search::onIteration, called for the main thread's iterations. not while searching
+        void onIteration(std::function<void(const Result &)> callback) { m_searches[0]->onIteration(std::move(callback)); }
+
+    private:
+        Result search(const Board &board, const Limits &limits);
+
+        TranspositionTable m_table;
+        // m_searches[0] is the main thread
+        std::vector<std::unique_ptr<Search>> m_searches;
+        // runs the main thread's search for start()
+        std::thread m_thread;
+        Result m_result;
+    };
+}
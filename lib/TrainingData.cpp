@@ -0,0 +1,181 @@
+// # Copyright (c) Dylan Leclair
+#include "TrainingData.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace training
+{
+    namespace
+    {
+        const char fenPieces[] = " PRNBQKprnbqk";
+    }
+
+    Piece PackedPosition::at(int square) const
+    {
+        if (!(m_occupancy & SQUARE_BB(square)))
+            return Piece::EMPTY;
+        // the piece's place among the occupied squares before it
+        const int index = bitboard::popCount(m_occupancy & (SQUARE_BB(square) - 1));
+        return static_cast<Piece>((m_pieces[index / 2] >> (index % 2 * 4)) & 15);
+    }
+
+    PackedPosition pack(const Board &board, int score, int result)
+    {
+        PackedPosition position{};
+        const Bitboards &bitboards = board.getBitboards();
+        position.m_occupancy = bitboards.occupied();
+        Bitboard occupied = position.m_occupancy;
+        for (int index = 0; occupied && index < 32; index++)
+        {
+            int square = bitboard::popLsb(occupied);
+            position.m_pieces[index / 2] |= static_cast<uint8_t>(bitboards.at(square) << (index % 2 * 4));
+        }
+        // the pieces past the 32nd couldn't be stored
+        position.m_occupancy &= ~occupied;
+
+        const bool white = board.getPlayerToMove() == PlayerColor::White;
+        position.m_state = static_cast<uint8_t>(board.getPlayerToMove() | board.getCastlingRights() << 1);
+        position.m_enPassant = static_cast<int8_t>(board.getEnPassantSquare());
+        position.m_halfmoveClock = static_cast<uint8_t>(std::min(board.getHalfmoveClock(), 255));
+        position.m_fullmoveNumber = static_cast<uint16_t>(std::min(board.getFullmoveNumber(), 65535));
+        position.m_result = static_cast<int8_t>(std::clamp(result, -1, 1));
+        position.m_score = static_cast<int16_t>(std::clamp(white ? score : -score, -32767, 32767));
+        return position;
+    }
+
+    std::string toFen(const PackedPosition &position)
+    {
+        std::string fen;
+        for (int row = 0; row < 8; row++)
+        {
+            int empty = 0;
+            for (int col = 0; col < 8; col++)
+            {
+                Piece piece = position.at(SQUARE(row, col));
+                if (piece == Piece::EMPTY || piece > Piece::BLACK_KING)
+                {
+                    empty++;
+                    continue;
+                }
+                if (empty)
+                    fen += static_cast<char>('0' + empty);
+                empty = 0;
+                fen += fenPieces[piece];
+            }
+            if (empty)
+                fen += static_cast<char>('0' + empty);
+            if (row < 7)
+                fen += '/';
+        }
+
+        fen += position.sideToMove() == PlayerColor::Black ? " b " : " w ";
+        const uint8_t rights = position.castling();
+        if (rights & CastlingRights::WHITE_KINGSIDE) fen += 'K';
+        if (rights & CastlingRights::WHITE_QUEENSIDE) fen += 'Q';
+        if (rights & CastlingRights::BLACK_KINGSIDE) fen += 'k';
+        if (rights & CastlingRights::BLACK_QUEENSIDE) fen += 'q';
+        if (!rights) fen += '-';
+
+        fen += ' ';
+        if (position.m_enPassant >= 0 && position.m_enPassant < 64)
+        {
+            fen += static_cast<char>('a' + COL_OF(position.m_enPassant));
+            fen += static_cast<char>('8' - ROW_OF(position.m_enPassant));
+        }
+        else
+        {
+            fen += '-';
+        }
+        return fen + " " + std::to_string(position.m_halfmoveClock) + " " + std::to_string(std::max<int>(1, position.m_fullmoveNumber));
+    }
+
+    bool unpack(const PackedPosition &position, Board &board)
+    {
+        return board.setFen(toFen(position));
+    }
+
+    bool Writer::open(const std::string &path)
+    {
+        m_file.open(path, std::ios::binary | std::ios::app);
+        if (!m_file)
+        {
+            std::cout << "Error at Writer: can't write " << path << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    void Writer::write(const PackedPosition *positions, size_t count)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_file.write(reinterpret_cast<const char *>(positions), static_cast<std::streamsize>(count * sizeof(PackedPosition)));
+        m_file.flush();
+    }
+
+    bool Reader::open(const std::string &path)
+    {
+        if (!m_file.open(path))
+        {
+            std::cout << "Error at Reader: can't read " << path << std::endl;
+            return false;
+        }
+        if (m_file.size() % sizeof(PackedPosition) != 0)
+        {
+            std::cout << "Error at Reader: " << path << " isn't whole " << sizeof(PackedPosition) << " byte records" << std::endl;
+            m_file.close();
+            return false;
+        }
+        return true;
+    }
+
+    PackedPosition Reader::operator[](size_t index) const
+    {
+        // copied out, the mapping makes no promise about alignment on every platform
+        PackedPosition position;
+        std::memcpy(&position, m_file.data() + index * sizeof(PackedPosition), sizeof(PackedPosition));
+        return position;
+    }
+
+    bool shuffle(const std::string &from, const std::string &to, uint64_t seed)
+    {
+        Reader reader;
+        if (!reader.open(from))
+            return false;
+        std::ofstream out(to, std::ios::binary | std::ios::trunc);
+        if (!out)
+        {
+            std::cout << "Error at shuffle: can't write " << to << std::endl;
+            return false;
+        }
+
+        // indices are 32 bit to halve the memory the order takes: that's still 128GB of records
+        if (reader.size() > UINT32_MAX)
+        {
+            std::cout << "Error at shuffle: " << from << " has too many records" << std::endl;
+            return false;
+        }
+        std::vector<uint32_t> order(reader.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::shuffle(order.begin(), order.end(), std::mt19937_64(seed));
+
+        // written a block at a time rather than a record at a time
+        std::vector<PackedPosition> block;
+        block.reserve(4096);
+        for (uint32_t index : order)
+        {
+            block.push_back(reader[index]);
+            if (block.size() == block.capacity())
+            {
+                out.write(reinterpret_cast<const char *>(block.data()), static_cast<std::streamsize>(block.size() * sizeof(PackedPosition)));
+                block.clear();
+            }
+        }
+        out.write(reinterpret_cast<const char *>(block.data()), static_cast<std::streamsize>(block.size() * sizeof(PackedPosition)));
+        return static_cast<bool>(out);
+    }
+}
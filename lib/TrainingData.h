@@ -0,0 +1,73 @@
+// # Copyright (c) Dylan Leclair
+#pragma once
+
+#include "Board.h"
+#include "MappedFile.h"
+
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+
+/// @brief labelled positions for tuning the evaluation, in fixed size records.
+/// a file is nothing but records back to back (no header), in the machine's byte order (little endian everywhere
+/// the engine runs): files are merged by concatenating them, and record i is at i * 32 bytes.
+namespace training
+{
+    /// @brief one position, its search score and how the game it came from ended.
+    struct PackedPosition
+    {
+        Bitboard m_occupancy;     // every square with a piece on it
+        uint8_t m_pieces[16];     // the Piece on each of those squares in order, a nibble each, low nibble first
+        uint8_t m_state;          // side to move in bit 0, CastlingRights in bits 1-4
+        int8_t m_enPassant;       // square, or -1
+        uint8_t m_halfmoveClock;  // capped at 255
+        int8_t m_result;          // for white: 1 won, 0 drawn, -1 lost
+        int16_t m_score;          // the search's score for white, in centipawns
+        uint16_t m_fullmoveNumber;
+
+        PlayerColor sideToMove() const { return static_cast<PlayerColor>(m_state & 1); }
+        uint8_t castling() const { return m_state >> 1; }
+        Piece at(int square) const;
+    };
+    static_assert(sizeof(PackedPosition) == 32, "records are 32 bytes on disk");
+
+    /// @brief the board's position, with the score (for the side to move, as the search gives it) and result
+    /// (for white) turned round to white's side. the board should have at most 32 pieces.
+    PackedPosition pack(const Board &board, int score, int result);
+    std::string toFen(const PackedPosition &position);
+    /// @brief sets the board up at the record's position (with no history). false if the record isn't a position.
+    bool unpack(const PackedPosition &position, Board &board);
+
+    /// @brief appends records to a file, from any number of threads. each write() lands in one piece, so a game's
+    /// positions stay together until the file is shuffled.
+    class Writer
+    {
+    public:
+        /// @brief false (with an error printed) if the file can't be opened
+        bool open(const std::string &path);
+        void write(const PackedPosition *positions, size_t count);
+        bool isOpen() const { return m_file.is_open(); }
+
+    private:
+        std::ofstream m_file;
+        std::mutex m_mutex;
+    };
+
+    /// @brief the records of a file, mapped for random access
+    class Reader
+    {
+    public:
+        /// @brief false (with an error printed) if the file can't be mapped or isn't whole records
+        bool open(const std::string &path);
+        size_t size() const { return m_file.size() / sizeof(PackedPosition); }
+        PackedPosition operator[](size_t index) const;
+
+    private:
+        MappedFile m_file;
+    };
+
+    /// @brief writes the records of one file to another in a random order. the input is read through the
+    /// mapping, so it doesn't have to fit in memory, only its index.
+    bool shuffle(const std::string &from, const std::string &to, uint64_t seed);
+}
@@ -0,0 +1,145 @@
+// # Copyright (c) Dylan Leclair
+#include "TranspositionTable.h"
+#include "Search.h"
+
+namespace search
+{
+    namespace
+    {
+        // data word layout: move (16) | score (16) | depth (8) | bound (2) | age (6)
+        uint64_t packData(Move move, int score, int depth, Bound bound, uint8_t age)
+        {
+            return static_cast<uint64_t>(move.raw()) |
+                   static_cast<uint64_t>(static_cast<uint16_t>(score)) << 16 |
+                   static_cast<uint64_t>(static_cast<uint8_t>(depth)) << 32 |
+                   static_cast<uint64_t>(bound) << 40 |
+                   static_cast<uint64_t>(age) << 42;
+        }
+
+        Move dataMove(uint64_t data) { return Move::fromRaw(static_cast<uint16_t>(data)); }
+        int dataScore(uint64_t data) { return static_cast<int16_t>(data >> 16); }
+        int dataDepth(uint64_t data) { return static_cast<int8_t>(data >> 32); }
+        Bound dataBound(uint64_t data) { return static_cast<Bound>((data >> 40) & 3); }
+        uint8_t dataAge(uint64_t data) { return static_cast<uint8_t>(data >> 42); }
+    }
+
+    TranspositionTable::TranspositionTable(size_t megabytes)
+    {
+        resize(megabytes);
+    }
+
+    void TranspositionTable::resize(size_t megabytes)
+    {
+        size_t buckets = 1;
+        while (buckets * 2 * sizeof(Bucket) <= megabytes * 1024 * 1024)
+            buckets *= 2;
+
+        if (buckets != m_bucketCount)
+        {
+            m_buckets.reset(); // don't hold both tables at once
+            m_buckets.reset(new Bucket[buckets]);
+            m_bucketCount = buckets;
+        }
+        clear();
+    }
+
+    void TranspositionTable::clear()
+    {
+        for (size_t i = 0; i < m_bucketCount; i++)
+        {
+            for (int j = 0; j < BUCKET_SIZE; j++)
+            {
+                m_buckets[i].m_keys[j].store(0, std::memory_order_relaxed);
+                m_buckets[i].m_data[j].store(0, std::memory_order_relaxed);
+            }
+        }
+        m_age = 0;
+    }
+
+    bool TranspositionTable::probe(uint64_t key, TTEntry &entry) const
+    {
+        const Bucket &bucket = bucketFor(key);
+        for (int i = 0; i < BUCKET_SIZE; i++)
+        {
+            uint64_t data = bucket.m_data[i].load(std::memory_order_relaxed);
+            if ((bucket.m_keys[i].load(std::memory_order_relaxed) ^ data) == key && dataBound(data) != BOUND_NONE)
+            {
+                entry.m_move = dataMove(data);
+                entry.m_score = dataScore(data);
+                entry.m_depth = dataDepth(data);
+                entry.m_bound = dataBound(data);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void TranspositionTable::store(uint64_t key, Move move, int score, int depth, Bound bound)
+    {
+        Bucket &bucket = bucketFor(key);
+
+        // the same position if it's already here, otherwise whichever entry is worth least:
+        // shallow entries and ones left over from earlier searches go first
+        int replace = 0;
+        int worstValue = INT32_MAX;
+        for (int i = 0; i < BUCKET_SIZE; i++)
+        {
+            uint64_t data = bucket.m_data[i].load(std::memory_order_relaxed);
+            if ((bucket.m_keys[i].load(std::memory_order_relaxed) ^ data) == key)
+            {
+                // a shallower result for the same position is still fresher than a much deeper old one,
+                // but don't let it throw away a deep exact score or the best move
+                if (bound != BOUND_EXACT && dataAge(data) == m_age && depth < dataDepth(data) - 2)
+                    return;
+                if (move.isNull())
+                    move = dataMove(data);
+                replace = i;
+                break;
+            }
+
+            int relativeAge = (AGE_MASK + 1 + m_age - dataAge(data)) & AGE_MASK;
+            int value = dataBound(data) == BOUND_NONE ? INT32_MIN : dataDepth(data) - 8 * relativeAge;
+            if (value < worstValue)
+            {
+                worstValue = value;
+                replace = i;
+            }
+        }
+
+        uint64_t data = packData(move, score, depth, bound, m_age);
+        bucket.m_keys[replace].store(key ^ data, std::memory_order_relaxed);
+        bucket.m_data[replace].store(data, std::memory_order_relaxed);
+    }
+
+    int TranspositionTable::hashfull() const
+    {
+        int used = 0;
+        for (size_t i = 0; i < 1000 / BUCKET_SIZE && i < m_bucketCount; i++)
+        {
+            for (int j = 0; j < BUCKET_SIZE; j++)
+            {
+                uint64_t data = m_buckets[i].m_data[j].load(std::memory_order_relaxed);
+                used += dataBound(data) != BOUND_NONE && dataAge(data) == m_age;
+            }
+        }
+        return used;
+    }
+
+    int scoreToTable(int score, int ply)
+    {
+        if (score >= MATE_BOUND)
+            return score + ply;
+        if (score <= -MATE_BOUND)
+            return score - ply;
+        return score;
+    }
+
+    int scoreFromTable(int score, int ply)
+    {
+        if (score >= MATE_BOUND)
+            return score - ply;
+        if (score <= -MATE_BOUND)
+            return score + ply;
+        return score;
+    }
+}
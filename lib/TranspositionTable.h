@@ -0,0 +1,82 @@
+// # Copyright (c) Dylan Leclair
+#pragma once
+
+#include "Move.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace search
+{
+    const size_t DEFAULT_HASH_MB = 16;
+
+    // what the stored score says about the real one
+    enum Bound : uint8_t
+    {
+        BOUND_NONE = 0,  // empty slot
+        BOUND_UPPER = 1, // failed low, real score <= stored score
+        BOUND_LOWER = 2, // failed high, real score >= stored score
+        BOUND_EXACT = 3,
+    };
+
+    /// @brief an entry as read back from the table.
+    struct TTEntry
+    {
+        Move m_move; // the null move if there's no best move
+        int m_score{0};
+        int m_depth{0};
+        Bound m_bound{BOUND_NONE};
+    };
+
+    /// @brief a fixed size hash table of search results, shared by every search thread without locks.
+    ///
+    /// entries live in buckets of four, one cache line each, so a probe costs a single memory access.
+    /// every entry is two 64 bit words, the data and the key XORed with the data. two threads writing the same slot
+    /// at once can leave a key from one and data from the other, which then simply fails to verify and reads as a miss.
+    class TranspositionTable
+    {
+    public:
+        explicit TranspositionTable(size_t megabytes = DEFAULT_HASH_MB);
+
+        /// @brief rounds down to a power of two number of buckets. only reallocates if the size actually changes,
+        /// and throws the contents away either way. not safe while a search is running.
+        void resize(size_t megabytes);
+
+        /// @brief empties the table without reallocating, e.g. between games. not safe while a search is running.
+        void clear();
+
+        /// @brief starts a new search: entries from older searches become the first to be replaced.
+        void newSearch() { m_age = (m_age + 1) & AGE_MASK; }
+
+        bool probe(uint64_t key, TTEntry &entry) const;
+        void store(uint64_t key, Move move, int score, int depth, Bound bound);
+
+        /// @brief permille of the table in use by the current search, estimated from the first buckets (for UCI).
+        int hashfull() const;
+
+        size_t sizeMb() const { return m_bucketCount * sizeof(Bucket) / (1024 * 1024); }
+
+    private:
+        static const int BUCKET_SIZE = 4;
+        static const uint8_t AGE_MASK = 63;
+
+        struct alignas(64) Bucket
+        {
+            std::atomic<uint64_t> m_keys[BUCKET_SIZE];
+            std::atomic<uint64_t> m_data[BUCKET_SIZE];
+        };
+
+        Bucket &bucketFor(uint64_t key) const { return m_buckets[key & (m_bucketCount - 1)]; }
+
+        std::unique_ptr<Bucket[]> m_buckets;
+        size_t m_bucketCount{0};
+        uint8_t m_age{0};
+    };
+
+    // mate scores are stored relative to the position they were found in, not the root,
+    // so they stay right when the same position turns up at a different ply
+    int scoreToTable(int score, int ply);
+    int scoreFromTable(int score, int ply);
+}
@@ -0,0 +1,298 @@
+// # Copyright (c) Dylan Leclair
+#include "Uci.h"
+#include "Nnue.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+namespace uci
+{
+    static const char *START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+    Engine::Engine(std::ostream &out)
+        : m_out(out)
+    {
+        m_board.setFen(START_FEN);
+        m_search.onIteration([this](const search::Result &result) { printInfo(result); });
+    }
+
+    Engine::~Engine()
+    {
+        stop();
+        waitForSearch();
+    }
+
+    void Engine::loop(std::istream &in)
+    {
+        std::string line;
+        while (std::getline(in, line))
+        {
+            if (!handle(line))
+                break;
+        }
+        stop();
+        waitForSearch();
+    }
+
+    bool Engine::handle(const std::string &line)
+    {
+        std::istringstream command(line);
+        std::string token;
+        if (!(command >> token))
+            return true;
+
+        if (token == "uci")
+            uci();
+        else if (token == "isready")
+            send("readyok");
+        else if (token == "ucinewgame")
+        {
+            stop();
+            waitForSearch();
+            m_search.table().clear();
+            m_board.setFen(START_FEN);
+        }
+        else if (token == "setoption")
+        {
+            stop();
+            waitForSearch();
+            setOption(command);
+        }
+        else if (token == "position")
+        {
+            stop();
+            waitForSearch();
+            position(command);
+        }
+        else if (token == "go")
+            go(command);
+        else if (token == "stop")
+        {
+            stop();
+            waitForSearch();
+        }
+        else if (token == "ponderhit")
+            ponderhit();
+        else if (token == "quit")
+            return false;
+        else if (token != "debug" && token != "register")
+            send("info string Unknown command: " + line);
+        return true;
+    }
+
+    void Engine::waitForSearch()
+    {
+        m_search.wait();
+    }
+
+    void Engine::uci()
+    {
+        send("id name chess 0.1.0");
+        send("id author Dylan Leclair");
+        send("option name Hash type spin default " + std::to_string(search::DEFAULT_HASH_MB) + " min 1 max 65536");
+        send("option name Threads type spin default 1 min 1 max 256");
+        send("option name Ponder type check default false");
+        send("option name EvalFile type string default <empty>");
+        send("uciok");
+    }
+
+    void Engine::setOption(std::istringstream &command)
+    {
+        // setoption name <name, maybe several words> [value <value, maybe several words>]
+        std::string token, name, value;
+        std::string *field = nullptr;
+        while (command >> token)
+        {
+            if (token == "name")
+                field = &name;
+            else if (token == "value")
+                field = &value;
+            else if (field)
+                *field += (field->empty() ? "" : " ") + token;
+        }
+        // option names aren't case sensitive
+        std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return std::tolower(c); });
+
+        if (name == "hash")
+            m_search.table().resize(std::clamp(std::atoi(value.c_str()), 1, 65536));
+        else if (name == "threads")
+            m_search.setThreads(std::clamp(std::atoi(value.c_str()), 1, 256));
+        else if (name == "evalfile")
+        {
+            if (value.empty() || value == "<empty>")
+                nnue::unload();
+            else if (!nnue::load(value))
+                send("info string Error at setoption: can't load network " + value);
+        }
+        else if (name != "ponder")
+            send("info string Unknown option: " + name);
+    }
+
+    void Engine::position(std::istringstream &command)
+    {
+        // position startpos|fen <fen> [moves <move> ...]
+        std::string token, fen;
+        command >> token;
+        if (token == "startpos")
+        {
+            fen = START_FEN;
+            command >> token;
+        }
+        else if (token == "fen")
+        {
+            while (command >> token && token != "moves")
+                fen += token + " ";
+        }
+
+        if (fen.empty() || !m_board.setFen(fen))
+        {
+            send("info string Error at position: invalid position " + fen);
+            m_board.setFen(START_FEN);
+            return;
+        }
+        if (token != "moves")
+            return;
+
+        while (command >> token)
+        {
+            MoveList moves;
+            m_board.getLegalMoves(moves);
+            auto move = std::find_if(moves.begin(), moves.end(), [&token](const Move &move) { return move.toString() == token; });
+            if (move == moves.end())
+            {
+                send("info string Error at position: illegal move " + token);
+                return;
+            }
+            m_board.move(*move);
+        }
+    }
+
+    void Engine::go(std::istringstream &command)
+    {
+        // only one search at a time
+        stop();
+        waitForSearch();
+
+        int time[2] = {0, 0};
+        int increment[2] = {0, 0};
+        int movesToGo = 0, moveTime = 0, depth = 0;
+        uint64_t nodes = 0;
+        bool infinite = false, ponder = false;
+
+        std::string token;
+        while (command >> token)
+        {
+            if (token == "wtime")
+                command >> time[PlayerColor::White];
+            else if (token == "btime")
+                command >> time[PlayerColor::Black];
+            else if (token == "winc")
+                command >> increment[PlayerColor::White];
+            else if (token == "binc")
+                command >> increment[PlayerColor::Black];
+            else if (token == "movestogo")
+                command >> movesToGo;
+            else if (token == "movetime")
+                command >> moveTime;
+            else if (token == "depth")
+                command >> depth;
+            else if (token == "nodes")
+                command >> nodes;
+            else if (token == "infinite")
+                infinite = true;
+            else if (token == "ponder")
+                ponder = true;
+        }
+
+        search::Limits limits;
+        PlayerColor us = m_board.getPlayerToMove();
+        if (moveTime > 0)
+            limits.m_timeMs = moveTime;
+        else if (time[us] > 0 && !infinite)
+            limits = search::clockLimits(time[us], increment[us], movesToGo);
+        if (depth > 0)
+            limits.m_depth = depth;
+        limits.m_nodes = nodes;
+        limits.m_ponder = ponder;
+
+        {
+            std::lock_guard<std::mutex> lock(m_holdMutex);
+            m_holdBestMove = infinite || ponder;
+            m_infinite = infinite;
+        }
+        m_searchStart = std::chrono::steady_clock::now();
+        m_search.start(m_board, limits, [this](const search::Result &result) {
+            std::unique_lock<std::mutex> lock(m_holdMutex);
+            m_holdChanged.wait(lock, [this]() { return !m_holdBestMove; });
+            lock.unlock();
+            printBestMove(result);
+        });
+    }
+
+    void Engine::ponderhit()
+    {
+        // the search goes on with the clock running, and reports its move when done
+        m_search.ponderhit();
+        {
+            std::lock_guard<std::mutex> lock(m_holdMutex);
+            if (!m_infinite)
+                m_holdBestMove = false;
+        }
+        m_holdChanged.notify_all();
+    }
+
+    void Engine::stop()
+    {
+        m_search.stop();
+        {
+            std::lock_guard<std::mutex> lock(m_holdMutex);
+            m_holdBestMove = false;
+        }
+        m_holdChanged.notify_all();
+    }
+
+    void Engine::printInfo(const search::Result &result)
+    {
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - m_searchStart).count();
+        uint64_t nodes = m_search.nodes();
+
+        std::string score;
+        if (std::abs(result.m_score) >= search::MATE_BOUND)
+        {
+            // in moves, not plies, negative when getting mated
+            int plies = search::MATE_SCORE - std::abs(result.m_score);
+            score = "mate " + std::to_string(result.m_score > 0 ? (plies + 1) / 2 : -(plies / 2));
+        }
+        else
+            score = "cp " + std::to_string(result.m_score);
+
+        std::string line = "info depth " + std::to_string(result.m_depth) + " score " + score +
+                           " nodes " + std::to_string(nodes) +
+                           " nps " + std::to_string(nodes * 1000 / std::max<int64_t>(elapsed, 1)) +
+                           " hashfull " + std::to_string(m_search.table().hashfull()) +
+                           " time " + std::to_string(elapsed) + " pv";
+        for (const Move &move : result.m_pv)
+            line += " " + move.toString();
+        send(line);
+    }
+
+    void Engine::printBestMove(const search::Result &result)
+    {
+        if (result.m_bestMove.isNull())
+        {
+            send("bestmove 0000");
+            return;
+        }
+        std::string line = "bestmove " + result.m_bestMove.toString();
+        if (result.m_pv.size() >= 2 && result.m_pv[0] == result.m_bestMove)
+            line += " ponder " + result.m_pv[1].toString();
+        send(line);
+    }
+
+    void Engine::send(const std::string &line)
+    {
+        std::lock_guard<std::mutex> lock(m_outMutex);
+        m_out << line << std::endl;
+    }
+}
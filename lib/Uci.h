@@ -0,0 +1,64 @@
+// # Copyright (c) Dylan Leclair
+#pragma once
+
+#include "Board.h"
+#include "ThreadedSearch.h"
+
+#include <condition_variable>
+#include <istream>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+namespace uci
+{
+    /// @brief the engine side of the Universal Chess Interface: commands come in a line at a time, replies go to the
+    /// output stream. searches run in the background, so stop, isready and ponderhit are answered while searching.
+    ///
+    /// supported: uci, isready, ucinewgame, setoption (Hash, Threads, EvalFile), position (startpos or fen, then moves),
+    /// go (wtime btime winc binc movestogo movetime nodes depth infinite ponder), stop, ponderhit and quit.
+    class Engine
+    {
+    public:
+        explicit Engine(std::ostream &out);
+        // stops any search
+        ~Engine();
+
+        /// @brief reads commands until quit or the end of the input
+        void loop(std::istream &in);
+
+        /// @brief handles one command, returns false for quit
+        bool handle(const std::string &line);
+
+        /// @brief waits until the current search, if any, has reported its best move
+        void waitForSearch();
+
+    private:
+        void uci();
+        void setOption(std::istringstream &command);
+        void position(std::istringstream &command);
+        void go(std::istringstream &command);
+        void ponderhit();
+        // stops the search, which still reports its best move
+        void stop();
+
+        void printInfo(const search::Result &result);
+        void printBestMove(const search::Result &result);
+        void send(const std::string &line);
+
+        std::ostream &m_out;
+        std::mutex m_outMutex;
+
+        Board m_board;
+        search::ThreadedSearch m_search;
+        std::chrono::steady_clock::time_point m_searchStart;
+
+        // "go infinite" and "go ponder" mustn't report a move until told to (by stop, or ponderhit for pondering),
+        // even if the search ends on its own
+        std::mutex m_holdMutex;
+        std::condition_variable m_holdChanged;
+        bool m_holdBestMove{false};
+        bool m_infinite{false};
+    };
+}
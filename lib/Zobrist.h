@@ -0,0 +1,58 @@
+// # Copyright (c) Dylan Leclair
+#pragma once
+
+#include "Piece.h"
+
+#include <cstdint>
+
+// random keys for hashing a position: the hash is the XOR of the keys of everything in it.
+// the keys are generated at compile time, so they're the same on every run and need no initialization.
+namespace zobrist
+{
+    struct Keys
+    {
+        uint64_t m_pieces[12][64]; // indexed by Piece - 1
+        uint64_t m_sideToMove;     // in the hash when black is to move
+        uint64_t m_castling[16];   // one per combination of CastlingRights
+        uint64_t m_enPassantFile[8];
+    };
+
+    constexpr uint64_t splitMix64(uint64_t &state)
+    {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    constexpr Keys generateKeys()
+    {
+        Keys keys{};
+        uint64_t state = 585;
+        for (int piece = 0; piece < 12; piece++)
+        {
+            for (int square = 0; square < 64; square++)
+            {
+                keys.m_pieces[piece][square] = splitMix64(state);
+            }
+        }
+        keys.m_sideToMove = splitMix64(state);
+        // no rights at all hashes to nothing, like an empty square
+        for (int rights = 1; rights < 16; rights++)
+        {
+            keys.m_castling[rights] = splitMix64(state);
+        }
+        for (int file = 0; file < 8; file++)
+        {
+            keys.m_enPassantFile[file] = splitMix64(state);
+        }
+        return keys;
+    }
+
+    inline constexpr Keys keys = generateKeys();
+
+    inline uint64_t piece(Piece p, int square)
+    {
+        return keys.m_pieces[p - 1][square];
+    }
+}
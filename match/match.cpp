@@ -0,0 +1,246 @@
+// # Copyright (c) Dylan Leclair
+
+#include "Board.h"
+#include "Epd.h"
+#include "MappedFile.h"
+#include "Match.h"
+#include "Nnue.h"
+#include "Pgn.h"
+#include "ThreadedSearch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// a few balanced openings, for when there's no --openings file
+static const std::vector<std::string> defaultOpenings = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "rnbqkbnr/pppp1ppp/8/4p3/4P3/8/PPPP1PPP/RNBQKBNR w KQkq - 0 2",        // 1. e4 e5
+    "rnbqkbnr/pp1ppppp/8/2p5/4P3/8/PPPP1PPP/RNBQKBNR w KQkq - 0 2",        // 1. e4 c5
+    "rnbqkbnr/pppp1ppp/4p3/8/4P3/8/PPPP1PPP/RNBQKBNR w KQkq - 0 2",        // 1. e4 e6
+    "rnbqkbnr/pp1ppppp/2p5/8/4P3/8/PPPP1PPP/RNBQKBNR w KQkq - 0 2",        // 1. e4 c6
+    "rnbqkbnr/ppp1pppp/8/3p4/3P4/8/PPP1PPPP/RNBQKBNR w KQkq - 0 2",        // 1. d4 d5
+    "rnbqkb1r/pppppppp/5n2/8/3P4/8/PPP1PPPP/RNBQKBNR w KQkq - 1 2",        // 1. d4 Nf6
+    "rnbqkbnr/pppppppp/8/8/2P5/8/PP1PPPPP/RNBQKBNR b KQkq - 0 1",          // 1. c4
+    "rnbqkbnr/pppppppp/8/8/8/5N2/PPPPPPPP/RNBQKB1R b KQkq - 1 1",          // 1. Nf3
+    "r1bqkbnr/pppp1ppp/2n5/1B2p3/4P3/5N2/PPPP1PPP/RNBQK2R b KQkq - 3 3",   // Ruy Lopez
+};
+
+static void printUsage()
+{
+    std::cout << "usage: chess_match --engine <config> --engine <config> [--games N] [--concurrency N]" << std::endl
+              << "                   [--openings <file>] [--sprt elo0 elo1] [--alpha A] [--beta B]" << std::endl
+              << "                   [--pgn <file>] [--nnue <network file>] [--no-adjudication]" << std::endl
+              << std::endl
+              << "plays the two configurations against each other, each opening twice with the colours swapped." << std::endl
+              << "a configuration is comma separated keys: name, depth, nodes, movetime (ms), tc (seconds, e.g. 10+0.1)" << std::endl
+              << "and hash (MB), e.g. \"name=deeper,depth=6\" against \"name=base,depth=5\"." << std::endl
+              << "openings are FENs (one per line, EPD) or the final positions of the games in a .pgn file." << std::endl
+              << "with --sprt the match stops as soon as the test decides; --nnue evaluates with the network on both sides." << std::endl;
+}
+
+// the positions to start games from
+static bool loadOpenings(const std::string &path, std::vector<std::string> &openings)
+{
+    Board board;
+    if (path.size() > 4 && path.compare(path.size() - 4, 4, ".pgn") == 0)
+    {
+        MappedFile file;
+        if (!file.open(path, true))
+            return false;
+        pgn::Reader reader(file.view());
+        pgn::Game game;
+        std::string error;
+        while (reader.next(game))
+        {
+            if (pgn::replay(game, board, &error) >= 0)
+                openings.push_back(board.getFen());
+            else
+                std::cout << "Error at loadOpenings: skipping a game, " << error << std::endl;
+        }
+    }
+    else
+    {
+        EpdReader reader(path);
+        if (!reader.isOpen())
+            return false;
+        while (reader.next(board))
+            openings.push_back(board.getFen());
+    }
+    return !openings.empty();
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<match::EngineConfig> engines;
+    int games = 1000;
+    int concurrency = std::max(1u, std::thread::hardware_concurrency());
+    std::string openingsPath;
+    std::string pgnPath;
+    bool sprt = false;
+    match::Sprt test;
+    match::Adjudication adjudication;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--engine" && hasValue)
+        {
+            match::EngineConfig config;
+            if (!match::parseEngine(argv[++i], config))
+                return 1;
+            engines.push_back(config);
+        }
+        else if (arg == "--games" && hasValue)
+            games = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--concurrency" && hasValue)
+            concurrency = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--openings" && hasValue)
+            openingsPath = argv[++i];
+        else if (arg == "--pgn" && hasValue)
+            pgnPath = argv[++i];
+        else if (arg == "--sprt" && i + 2 < argc)
+        {
+            sprt = true;
+            test.m_elo0 = std::atof(argv[++i]);
+            test.m_elo1 = std::atof(argv[++i]);
+        }
+        else if (arg == "--alpha" && hasValue)
+            test.m_alpha = std::atof(argv[++i]);
+        else if (arg == "--beta" && hasValue)
+            test.m_beta = std::atof(argv[++i]);
+        else if (arg == "--nnue" && hasValue)
+        {
+            if (!nnue::load(argv[++i]))
+                return 1;
+        }
+        else if (arg == "--no-adjudication")
+        {
+            adjudication.m_drawMoves = 0;
+            adjudication.m_resignMoves = 0;
+            adjudication.m_maxPlies = 0;
+        }
+        else
+        {
+            printUsage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+    if (engines.size() != 2)
+    {
+        printUsage();
+        return 1;
+    }
+
+    std::vector<std::string> openings = defaultOpenings;
+    if (!openingsPath.empty())
+    {
+        openings.clear();
+        if (!loadOpenings(openingsPath, openings))
+        {
+            std::cout << "Error at main: no openings in " << openingsPath << std::endl;
+            return 1;
+        }
+    }
+
+    std::ofstream pgnFile;
+    if (!pgnPath.empty())
+    {
+        pgnFile.open(pgnPath);
+        if (!pgnFile)
+        {
+            std::cout << "Error at main: can't write " << pgnPath << std::endl;
+            return 1;
+        }
+    }
+
+    const match::EngineConfig &first = engines[0];
+    const match::EngineConfig &second = engines[1];
+    std::cout << first.m_name << " vs " << second.m_name << ": " << games << " games, " << openings.size()
+              << " openings, " << concurrency << " at a time";
+    if (sprt)
+        std::cout << ", SPRT elo0 " << test.m_elo0 << " elo1 " << test.m_elo1 << " alpha " << test.m_alpha << " beta " << test.m_beta;
+    std::cout << std::endl;
+
+    std::atomic<int> nextGame{0};
+    std::atomic<bool> decided{false};
+    std::mutex mutex;
+    match::Score score;
+    match::Sprt::Decision decision = match::Sprt::Decision::Continue;
+
+    auto work = [&]() {
+        // every game has its own board, every worker its own pair of searches, so nothing is shared but the results
+        search::ThreadedSearch firstSearch(first.m_hashMb), secondSearch(second.m_hashMb);
+        for (int game; !decided && (game = nextGame++) < games;)
+        {
+            // each opening twice in a row, the first engine white then black
+            const std::string &opening = openings[(game / 2) % openings.size()];
+            const bool firstIsWhite = game % 2 == 0;
+            match::GameRecord record = firstIsWhite
+                                           ? match::playGame(opening, first, second, firstSearch, secondSearch, adjudication)
+                                           : match::playGame(opening, second, first, secondSearch, firstSearch, adjudication);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (decided)
+                break;
+            const char *result = "1/2-1/2";
+            if (record.m_outcome == match::Outcome::Draw)
+                score.m_draws++;
+            else
+            {
+                bool whiteWon = record.m_outcome == match::Outcome::WhiteWins;
+                (whiteWon == firstIsWhite ? score.m_wins : score.m_losses)++;
+                result = whiteWon ? "1-0" : "0-1";
+            }
+
+            const std::string &white = firstIsWhite ? first.m_name : second.m_name;
+            const std::string &black = firstIsWhite ? second.m_name : first.m_name;
+            if (pgnFile)
+                pgnFile << match::toPgn(record, white, black, game + 1) << std::flush;
+
+            char line[256];
+            std::snprintf(line, sizeof(line), "game %d: %s - %s %s (%s, %zu plies)   +%d -%d =%d   elo %.1f +- %.1f",
+                          game + 1, white.c_str(), black.c_str(), result, record.m_reason.c_str(), record.m_moves.size(),
+                          score.m_wins, score.m_losses, score.m_draws, match::elo(score.ratio()), match::eloError(score));
+            std::cout << line;
+            if (sprt)
+            {
+                std::snprintf(line, sizeof(line), "   llr %.2f (%.2f, %.2f)", test.llr(score), test.lowerBound(), test.upperBound());
+                std::cout << line;
+                decision = test.decide(score);
+                decided = decision != match::Sprt::Decision::Continue;
+            }
+            std::cout << std::endl;
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int i = 1; i < concurrency; i++)
+        workers.emplace_back(work);
+    work();
+    for (std::thread &worker : workers)
+        worker.join();
+
+    char line[256];
+    std::snprintf(line, sizeof(line), "\n%s vs %s: +%d -%d =%d in %d games, score %.1f%%, elo %.1f +- %.1f (95%%)",
+                  first.m_name.c_str(), second.m_name.c_str(), score.m_wins, score.m_losses, score.m_draws,
+                  score.games(), 100 * score.ratio(), match::elo(score.ratio()), match::eloError(score));
+    std::cout << line << std::endl;
+    if (sprt)
+    {
+        const char *verdict = decision == match::Sprt::Decision::AcceptH1   ? "H1 accepted: the first engine is stronger"
+                              : decision == match::Sprt::Decision::AcceptH0 ? "H0 accepted: the first engine isn't stronger"
+                                                                             : "no decision yet";
+        std::snprintf(line, sizeof(line), "SPRT: llr %.2f (%.2f, %.2f), %s", test.llr(score), test.lowerBound(), test.upperBound(), verdict);
+        std::cout << line << std::endl;
+    }
+    return 0;
+}
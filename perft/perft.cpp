@@ -0,0 +1,170 @@
+// # Copyright (c) Dylan Leclair
+
+#include "Board.h"
+#include "Epd.h"
+#include "Perft.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define START_FEN "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static void printUsage()
+{
+    std::cout << "usage: chess_perft [--fen \"<fen>\"] [--depth N] [--divide] [--threads N] [--hash MB]" << std::endl
+              << "       chess_perft --corpus <file> [--max-nodes N] [--threads N] [--hash MB]" << std::endl
+              << std::endl
+              << "corpus lines look like \"<fen> ;D1 20 ;D2 400 ...\", '#' starts a comment." << std::endl
+              << "depths whose expected count is above --max-nodes are skipped." << std::endl
+              << "--threads splits the tree below the first two plies between threads, --hash caches subtree counts" << std::endl
+              << "(the table is kept across the corpus' positions, counts are by position so that's safe)." << std::endl;
+}
+
+static void printThreadStats(const perft::ParallelResult &result, bool hashed)
+{
+    for (size_t i = 0; i < result.m_threads.size(); i++)
+    {
+        const perft::ThreadStats &stats = result.m_threads[i];
+        std::cout << "thread " << i << ": " << stats.m_tasks << " subtrees (" << stats.m_stolen << " stolen), "
+                  << stats.m_nodes << " nodes in " << stats.m_seconds << "s";
+        if (hashed)
+            std::cout << ", " << stats.m_hashHits << "/" << stats.m_hashProbes << " hash hits";
+        std::cout << std::endl;
+    }
+}
+
+// runs every (position, depth) of the corpus, returns the number of mismatches
+static int runCorpus(const std::string &path, uint64_t maxNodes, int threads, perft::PerftTable *table)
+{
+    EpdReader reader(path);
+    if (!reader.isOpen())
+    {
+        std::cout << "Error at runCorpus: can't open " << path << std::endl;
+        return 1;
+    }
+
+    int failures = 0;
+    uint64_t totalNodes = 0;
+    Clock::time_point start = Clock::now();
+
+    Board board;
+    while (reader.next(board))
+    {
+        const std::string fen = board.getFen();
+        std::stringstream fields{std::string(reader.operations())};
+        std::string field;
+        while (std::getline(fields, field, ';'))
+        {
+            int depth;
+            uint64_t expected;
+            std::stringstream entry(field);
+            char d;
+            if (!(entry >> d >> depth >> expected) || d != 'D')
+                continue;
+            if (expected > maxNodes)
+                continue;
+
+            uint64_t nodes = perft::parallelPerft(board, depth, threads, table).m_nodes;
+            totalNodes += nodes;
+            bool ok = nodes == expected;
+            failures += ok ? 0 : 1;
+            std::cout << (ok ? "ok    " : "FAIL  ") << "D" << depth << " " << nodes;
+            if (!ok)
+                std::cout << " (expected " << expected << ")";
+            std::cout << "  " << fen << std::endl;
+        }
+    }
+    if (reader.invalidLines())
+    {
+        std::cout << "Error at runCorpus: " << reader.invalidLines() << " invalid positions in " << path << std::endl;
+        failures += static_cast<int>(reader.invalidLines());
+    }
+
+    double seconds = secondsSince(start);
+    std::cout << std::endl
+              << totalNodes << " nodes in " << seconds << "s ("
+              << static_cast<uint64_t>(totalNodes / (seconds > 0 ? seconds : 1)) << " nodes/sec)" << std::endl;
+    std::cout << failures << " failures" << std::endl;
+    return failures;
+}
+
+int main(int argc, char **argv)
+{
+    std::string fen = START_FEN;
+    std::string corpus;
+    int depth = 5;
+    bool divide = false;
+    uint64_t maxNodes = UINT64_MAX;
+    int threads = 1;
+    size_t hashMb = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--fen" && hasValue)
+            fen = argv[++i];
+        else if (arg == "--depth" && hasValue)
+            depth = std::atoi(argv[++i]);
+        else if (arg == "--divide")
+            divide = true;
+        else if (arg == "--corpus" && hasValue)
+            corpus = argv[++i];
+        else if (arg == "--max-nodes" && hasValue)
+            maxNodes = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--threads" && hasValue)
+            threads = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--hash" && hasValue)
+            hashMb = std::strtoull(argv[++i], nullptr, 10);
+        else
+        {
+            printUsage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    std::unique_ptr<perft::PerftTable> table;
+    if (hashMb)
+        table.reset(new perft::PerftTable(hashMb));
+
+    if (!corpus.empty())
+    {
+        return runCorpus(corpus, maxNodes, threads, table.get()) == 0 ? 0 : 1;
+    }
+
+    Board board(fen);
+    board.printBoard();
+    std::cout << std::endl;
+
+    Clock::time_point start = Clock::now();
+    uint64_t nodes;
+    if (divide)
+        nodes = perft::divide(board, depth, std::cout);
+    else if (threads == 1 && !table)
+        nodes = perft::perft(board, depth);
+    else
+    {
+        perft::ParallelResult result = perft::parallelPerft(board, depth, threads, table.get());
+        nodes = result.m_nodes;
+        printThreadStats(result, table != nullptr);
+    }
+    double seconds = secondsSince(start);
+
+    std::cout << std::endl
+              << "depth " << depth << ": " << nodes << " nodes in " << seconds << "s ("
+              << static_cast<uint64_t>(nodes / (seconds > 0 ? seconds : 1)) << " nodes/sec)" << std::endl;
+    return 0;
+}
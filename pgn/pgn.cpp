@@ -0,0 +1,80 @@
+// # Copyright (c) Dylan Leclair
+
+#include "MappedFile.h"
+#include "Pgn.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+
+using Clock = std::chrono::steady_clock;
+
+static void printUsage()
+{
+    std::cout << "usage: chess_pgn <file> [--threads N] [--max-errors N]" << std::endl
+              << std::endl
+              << "replays every game of a PGN file, checking each move is legal. games that aren't valid" << std::endl
+              << "are reported (the first --max-errors of them, default 20) and skipped." << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    std::string path;
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    uint64_t maxErrors = 20;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--threads" && hasValue)
+            threads = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--max-errors" && hasValue)
+            maxErrors = std::strtoull(argv[++i], nullptr, 10);
+        else if (path.empty() && arg.rfind("--", 0) != 0)
+            path = arg;
+        else
+        {
+            printUsage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+    if (path.empty())
+    {
+        printUsage();
+        return 1;
+    }
+
+    MappedFile file;
+    if (!file.open(path, true))
+    {
+        std::cout << "Error at main: can't open " << path << std::endl;
+        return 1;
+    }
+    const std::string_view text = file.view();
+
+    uint64_t errors = 0;
+    Clock::time_point start = Clock::now();
+    pgn::Stats stats = pgn::replayAll(text, threads, [&](const pgn::Game &game, const std::string &error) {
+        if (errors++ >= maxErrors)
+            return;
+        // the line is only worked out for the games that get reported
+        size_t line = 1 + std::count(text.begin(), text.begin() + game.m_offset, '\n');
+        std::cout << "Error at line " << line << ": " << error << std::endl;
+    });
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    if (seconds <= 0)
+        seconds = 1e-9;
+
+    if (errors > maxErrors)
+        std::cout << "(" << errors - maxErrors << " more errors)" << std::endl;
+    std::cout << stats.m_games << " games (" << stats.m_rejected << " rejected), " << stats.m_moves << " moves in "
+              << seconds << "s on " << threads << " threads" << std::endl
+              << static_cast<uint64_t>(stats.m_games / seconds) << " games/sec, "
+              << static_cast<uint64_t>(stats.m_moves / seconds) << " moves/sec, "
+              << static_cast<uint64_t>(text.size() / seconds / (1024 * 1024)) << " MB/sec" << std::endl;
+    return stats.m_rejected == 0 ? 0 : 1;
+}
@@ -0,0 +1,93 @@
+#include "gtest/gtest.h"
+#include "Attacks.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+
+TEST(attacks, sliders_match_ray_walk)
+{
+    std::mt19937_64 generator(585);
+
+    for (int square = 0; square < 64; square++)
+    {
+        for (int i = 0; i < 200; i++)
+        {
+            // sparse-ish occupancies so rays actually reach different lengths
+            Bitboard occupied = generator() & generator();
+            ASSERT_EQ(attacks::rookAttacks(square, occupied), attacks::slidingAttacks(true, square, occupied));
+            ASSERT_EQ(attacks::bishopAttacks(square, occupied), attacks::slidingAttacks(false, square, occupied));
+        }
+    }
+}
+
+TEST(attacks, queen_is_rook_and_bishop)
+{
+    // queen on d4 (row 4, col 3) of an empty board sees 27 squares
+    ASSERT_EQ(bitboard::popCount(attacks::queenAttacks(SQUARE(4, 3), 0)), 27);
+    // a blocker on d6 stops the ray but is itself attacked
+    Bitboard blocker = SQUARE_BB(SQUARE(2, 3));
+    Bitboard attacked = attacks::queenAttacks(SQUARE(4, 3), blocker);
+    ASSERT_TRUE(attacked & blocker);
+    ASSERT_FALSE(attacked & SQUARE_BB(SQUARE(1, 3)));
+}
+
+// built by the compiler, so these are checked at compile time
+static_assert(attacks::knightAttacks[SQUARE(0, 0)] == (SQUARE_BB(SQUARE(1, 2)) | SQUARE_BB(SQUARE(2, 1))));
+static_assert(attacks::kingAttacks[SQUARE(7, 7)] == (SQUARE_BB(SQUARE(6, 6)) | SQUARE_BB(SQUARE(6, 7)) | SQUARE_BB(SQUARE(7, 6))));
+static_assert(attacks::pawnPushes[PlayerColor::White][SQUARE(0, 4)] == 0);
+static_assert(attacks::between[SQUARE(0, 0)][SQUARE(7, 7)] == 0x0040201008040200ULL);
+static_assert(attacks::distance[SQUARE(0, 0)][SQUARE(7, 3)] == 7);
+
+TEST(attacks, lines_match_sliders)
+{
+    // the old definition: rays of the sliders on an empty board, and rays that stop at each other
+    for (int a = 0; a < 64; a++)
+    {
+        for (int b = 0; b < 64; b++)
+        {
+            Bitboard between = 0, line = 0;
+            for (bool rook : {true, false})
+            {
+                if (a != b && (attacks::slidingAttacks(rook, a, 0) & SQUARE_BB(b)))
+                {
+                    line = (attacks::slidingAttacks(rook, a, 0) & attacks::slidingAttacks(rook, b, 0)) | SQUARE_BB(a) | SQUARE_BB(b);
+                    between = attacks::slidingAttacks(rook, a, SQUARE_BB(b)) & attacks::slidingAttacks(rook, b, SQUARE_BB(a));
+                }
+            }
+            ASSERT_EQ(attacks::between[a][b], between) << a << " " << b;
+            ASSERT_EQ(attacks::line[a][b], line) << a << " " << b;
+
+            // a king needs as many moves as the larger of the row and column distance
+            int distance = std::max(std::abs(ROW_OF(a) - ROW_OF(b)), std::abs(COL_OF(a) - COL_OF(b)));
+            ASSERT_EQ(attacks::distance[a][b], distance);
+            ASSERT_EQ(distance == 1, (attacks::kingAttacks[a] & SQUARE_BB(b)) != 0);
+        }
+    }
+}
+
+TEST(attacks, leapers)
+{
+    for (int square = 0; square < 64; square++)
+    {
+        int row = ROW_OF(square), col = COL_OF(square);
+        // knights: two one way, one the other
+        Bitboard knight = 0;
+        for (int target = 0; target < 64; target++)
+        {
+            int rows = std::abs(ROW_OF(target) - row), cols = std::abs(COL_OF(target) - col);
+            if ((rows == 1 && cols == 2) || (rows == 2 && cols == 1))
+                knight |= SQUARE_BB(target);
+        }
+        ASSERT_EQ(attacks::knightAttacks[square], knight);
+
+        // pawns: white towards row 0, black towards row 7, nothing past the edge
+        Bitboard whitePush = row > 0 ? SQUARE_BB(square - 8) : 0;
+        Bitboard blackPush = row < 7 ? SQUARE_BB(square + 8) : 0;
+        ASSERT_EQ(attacks::pawnPushes[PlayerColor::White][square], whitePush);
+        ASSERT_EQ(attacks::pawnPushes[PlayerColor::Black][square], blackPush);
+        Bitboard sides = (col > 0 ? SQUARE_BB(square - 1) : 0) | (col < 7 ? SQUARE_BB(square + 1) : 0);
+        ASSERT_EQ(attacks::pawnAttacks[PlayerColor::White][square], row > 0 ? sides >> 8 : 0);
+        ASSERT_EQ(attacks::pawnAttacks[PlayerColor::Black][square], row < 7 ? sides << 8 : 0);
+    }
+}
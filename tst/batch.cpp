@@ -0,0 +1,65 @@
+#include "gtest/gtest.h"
+#include "Batch.h"
+#include "Board.h"
+#include "positions.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+static std::vector<std::string> sorted(const Move *begin, const Move *end)
+{
+    std::vector<std::string> moves;
+    for (const Move *move = begin; move != end; move++)
+        moves.push_back(move->toString() + "/" + std::to_string(move->flags()));
+    std::sort(moves.begin(), moves.end());
+    return moves;
+}
+
+TEST(batch, matches_board)
+{
+    std::vector<Board> boards = randomPositions(5000, 21);
+    batch::Positions positions;
+    positions.resize(boards.size());
+    for (size_t i = 0; i < boards.size(); i++)
+        positions.set(i, boards[i]);
+
+    batch::MoveLists moves;
+    batch::generateLegalMoves(positions, moves);
+    ASSERT_EQ(moves.size(), boards.size());
+    for (size_t i = 0; i < boards.size(); i++)
+    {
+        MoveList expected;
+        boards[i].getLegalMoves(expected);
+        ASSERT_EQ(sorted(moves.begin(i), moves.end(i)), sorted(expected.begin(), expected.end())) << boards[i].getFen();
+    }
+}
+
+TEST(batch, reuses_its_buffers)
+{
+    std::vector<Board> boards = randomPositions(300, 5);
+    batch::Positions positions;
+    positions.resize(boards.size());
+    for (size_t i = 0; i < boards.size(); i++)
+        positions.set(i, boards[i]);
+    batch::MoveLists moves;
+    batch::generateLegalMoves(positions, moves);
+    const Move *first = moves.begin(0);
+
+    // a smaller batch writes into the same lists
+    positions.resize(100);
+    batch::generateLegalMoves(positions, moves);
+    ASSERT_EQ(moves.size(), 100u);
+    ASSERT_EQ(moves.begin(0), first);
+    MoveList expected;
+    boards[99].getLegalMoves(expected);
+    ASSERT_EQ(moves.count(99), static_cast<int>(expected.size()));
+
+    // an empty board, and one with no king, go through too
+    positions.resize(102);
+    positions.set(100, Board{std::string("8/8/8/8/8/8/8/8 w - - 0 1")});
+    positions.set(101, Board{std::string("8/8/8/3r4/8/8/3P4/8 w - - 0 1")});
+    batch::generateLegalMoves(positions, moves);
+    ASSERT_EQ(moves.count(100), 0);
+    ASSERT_EQ(moves.count(101), 2);
+}
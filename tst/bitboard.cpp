@@ -0,0 +1,42 @@
+#include "gtest/gtest.h"
+#include "Board.h"
+#include "Bitboard.h"
+
+TEST(bitboard, start_position)
+{
+    Board b;
+    const Bitboards &bitboards = b.getBitboards();
+
+    ASSERT_TRUE(bitboard::popCount(bitboards.m_occupancy[PlayerColor::White]) == 16);
+    ASSERT_TRUE(bitboard::popCount(bitboards.m_occupancy[PlayerColor::Black]) == 16);
+    ASSERT_TRUE(bitboards.pieces(Piece::WHITE_KING) == SQUARE_BB(SQUARE(7, 4)));
+    ASSERT_TRUE(bitboards.pieces(Piece::BLACK_QUEEN) == SQUARE_BB(SQUARE(0, 3)));
+    ASSERT_TRUE(bitboards.pieces(Piece::WHITE_PAWN) == 0x00FF000000000000ULL);
+}
+
+TEST(bitboard, grid_view_matches_bitboards)
+{
+    Board b;
+    b.setValidMoves({6, 4}); // e2
+    ASSERT_TRUE(b.getValidMoves().size() == 2);
+    b.move(b.getValidMoves()[0]);
+
+    const std::vector<std::vector<Piece>> &grid = b.getBoard();
+    const Bitboards &bitboards = b.getBitboards();
+    for (int row = 0; row < 8; row++)
+    {
+        for (int col = 0; col < 8; col++)
+        {
+            Piece piece = grid[row][col];
+            ASSERT_TRUE(bitboards.at(SQUARE(row, col)) == piece);
+            if (piece != Piece::EMPTY)
+            {
+                ASSERT_TRUE(bitboards.pieces(piece) & SQUARE_BB(SQUARE(row, col)));
+            }
+        }
+    }
+
+    b.undo();
+    ASSERT_TRUE(b.getBoard()[6][4] == Piece::WHITE_PAWN);
+    ASSERT_TRUE(bitboard::popCount(bitboards.occupied()) == 32);
+}
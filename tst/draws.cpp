@@ -0,0 +1,94 @@
+#include "gtest/gtest.h"
+#include "Board.h"
+#include "Pgn.h"
+
+#include <string>
+#include <vector>
+
+static void play(Board &board, const std::vector<const char *> &moves)
+{
+    for (const char *san : moves)
+    {
+        Move move = pgn::parseSan(board, san);
+        ASSERT_FALSE(move.isNull()) << san << " in " << board.getFen();
+        board.move(move);
+    }
+}
+
+TEST(draws, threefold_repetition)
+{
+    Board board;
+    play(board, {"Nf3", "Nf6", "Ng1", "Ng8"});
+    // the second time round: only a draw to a search that started after the first
+    ASSERT_FALSE(board.isThreefoldRepetition());
+    ASSERT_TRUE(board.isDraw(5));
+    ASSERT_FALSE(board.isDraw(4));
+
+    play(board, {"Nf3", "Nf6", "Ng1", "Ng8"});
+    ASSERT_TRUE(board.isThreefoldRepetition());
+    ASSERT_TRUE(board.isDraw(0));
+    board.undo();
+    ASSERT_FALSE(board.isThreefoldRepetition());
+
+    // the kings go back, but the castling rights don't
+    Board kings{std::string("r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1")};
+    play(kings, {"Ke2", "Ke7", "Ke1", "Ke8"});
+    ASSERT_FALSE(kings.isDraw(100));
+    // from then on it's the same position each time
+    play(kings, {"Ke2", "Ke7", "Ke1", "Ke8", "Ke2", "Ke7", "Ke1", "Ke8"});
+    ASSERT_TRUE(kings.isThreefoldRepetition());
+
+    // the same position, but only by passing: the search doesn't count repetitions through a null move
+    Board nulls;
+    const uint64_t start = nulls.getHash();
+    play(nulls, {"Nf3"});
+    nulls.makeNullMove();
+    play(nulls, {"Ng1"});
+    nulls.makeNullMove();
+    ASSERT_EQ(nulls.getHash(), start);
+    ASSERT_FALSE(nulls.isDraw(100));
+}
+
+TEST(draws, fifty_move_rule)
+{
+    Board board{std::string("4k3/8/8/8/8/8/8/R3K3 w - - 98 80")};
+    play(board, {"Ra2"});
+    ASSERT_FALSE(board.isFiftyMoveDraw());
+    play(board, {"Kd7"});
+    ASSERT_TRUE(board.isFiftyMoveDraw());
+    ASSERT_TRUE(board.isDraw(1));
+
+    // a pawn move starts the count again
+    Board pawn{std::string("4k3/8/8/8/8/8/P7/4K3 w - - 99 80")};
+    play(pawn, {"a3"});
+    ASSERT_FALSE(pawn.isFiftyMoveDraw());
+
+    // mate on the hundredth ply still wins
+    Board mate{std::string("6k1/5ppp/8/8/8/8/8/R5K1 w - - 99 80")};
+    play(mate, {"Ra8#"});
+    ASSERT_FALSE(mate.isFiftyMoveDraw());
+}
+
+TEST(draws, upcoming_repetition)
+{
+    // black can take the knight back to where it started
+    Board board;
+    play(board, {"Nf3", "Nf6", "Ng1"});
+    ASSERT_TRUE(board.hasUpcomingRepetition(4));
+    // from the root, only a position that has repeated already counts
+    ASSERT_FALSE(board.hasUpcomingRepetition(0));
+    play(board, {"Ng8", "Nf3", "Nf6", "Ng1"});
+    ASSERT_TRUE(board.hasUpcomingRepetition(0));
+    // not once a pawn has moved
+    play(board, {"e5"});
+    ASSERT_FALSE(board.hasUpcomingRepetition(10));
+
+    // the queen goes round a triangle while the king does too. the way back is blocked by the pawn on d3
+    const std::vector<const char *> triangles = {"Kh7", "Qa4", "Kg6", "Qd4", "Kh6"};
+    Board open{std::string("8/8/7k/8/8/8/8/3QK3 b - - 0 1")};
+    play(open, triangles);
+    ASSERT_TRUE(open.hasUpcomingRepetition(10));
+    Board blocked{std::string("8/8/7k/8/8/3P4/8/3QK3 b - - 0 1")};
+    play(blocked, triangles);
+    ASSERT_FALSE(blocked.hasUpcomingRepetition(10));
+}
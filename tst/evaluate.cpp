@@ -0,0 +1,76 @@
+#include "gtest/gtest.h"
+#include "Board.h"
+#include "Evaluate.h"
+
+#include <random>
+
+TEST(evaluate, incremental_matches_recompute)
+{
+    std::mt19937 generator(585);
+    Board b{std::string("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1")};
+    const eval::Score start = b.getPsq();
+    const int startPhase = b.getPhase();
+    int played = 0;
+    for (; played < 80; played++)
+    {
+        MoveList moves;
+        b.getLegalMoves(moves);
+        if (moves.empty())
+            break;
+        b.move(moves[generator() % moves.size()]);
+        ASSERT_TRUE(b.getPsq() == b.computePsq());
+    }
+    for (; played > 0; played--)
+        b.undo();
+    ASSERT_TRUE(b.getPsq() == start);
+    ASSERT_EQ(b.getPhase(), startPhase);
+}
+
+TEST(evaluate, phase_and_symmetry)
+{
+    Board start;
+    ASSERT_EQ(start.getPhase(), eval::PHASE_MAX);
+    // the start position is balanced: only the tempo bonus is left
+    ASSERT_EQ(eval::evaluate(start), eval::evaluate(Board{std::string("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR b KQkq - 0 1")}));
+
+    Board kings{std::string("4k3/pp6/8/8/8/8/PP6/4K3 w - - 0 1")};
+    ASSERT_EQ(kings.getPhase(), 0);
+
+    // the same position with the colours swapped scores the same for the side to move
+    Board white{std::string("r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4")};
+    Board black{std::string("rnbqk2r/pppp1ppp/5n2/2b1p3/4P3/2N2N2/PPPP1PPP/R1BQKB1R b KQkq - 4 4")};
+    ASSERT_EQ(eval::evaluate(white), eval::evaluate(black));
+
+    // a knight up is clearly better
+    Board knightUp{std::string("4k3/pppppppp/8/8/8/8/PPPPPPPP/1N2K3 w - - 0 1")};
+    ASSERT_GT(eval::evaluate(knightUp), 200);
+}
+
+TEST(evaluate, static_exchange)
+{
+    // the legal move in the position written in long algebraic notation
+    auto see = [](const std::string &fen, const std::string &notation) {
+        Board b{fen};
+        MoveList moves;
+        b.getLegalMoves(moves);
+        for (const Move &move : moves)
+        {
+            if (move.toString() == notation)
+                return eval::see(b, move);
+        }
+        ADD_FAILURE() << notation << " isn't legal in " << fen;
+        return 0;
+    };
+
+    // undefended pawn
+    ASSERT_EQ(see("1k1r4/1pp4p/p7/4p3/8/P5P1/1PP4P/2K1R3 w - - 0 1", "e1e5"), 100);
+    // pawn takes a defended knight, and loses itself
+    ASSERT_EQ(see("4k3/8/3p4/4n3/3P4/8/8/4K3 w - - 0 1", "d4e5"), 220);
+    // queen takes a defended pawn
+    ASSERT_EQ(see("4k3/8/3p4/4p3/8/8/8/4QK2 w - - 0 1", "e1e5"), -800);
+    // the queen behind the rook takes back too, so the rook trade leaves white the pawn up
+    ASSERT_EQ(see("4r1k1/8/8/4p3/8/8/4R3/4QK2 w - - 0 1", "e2e5"), 100);
+    // a free promotion, and a pawn taken in passing
+    ASSERT_EQ(see("8/P7/8/8/8/8/8/k6K w - - 0 1", "a7a8q"), 800);
+    ASSERT_EQ(see("4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1", "e5d6"), 100);
+}
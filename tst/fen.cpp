@@ -0,0 +1,99 @@
+#include "gtest/gtest.h"
+#include "Board.h"
+#include "Epd.h"
+
+#include <cstdio>
+#include <fstream>
+
+TEST(fen, round_trip)
+{
+    const std::string fens[] = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 b - - 17 42",
+    };
+    Board b;
+    for (const std::string &fen : fens)
+    {
+        ASSERT_TRUE(b.setFen(fen));
+        ASSERT_EQ(b.getFen(), fen);
+        ASSERT_EQ(b.getHash(), b.computeHash());
+        ASSERT_EQ(Board(fen).getHash(), b.getHash());
+    }
+    // the default board is the start position
+    ASSERT_EQ(Board().getFen(), fens[0]);
+}
+
+TEST(fen, clocks_follow_the_game)
+{
+    Board b{std::string("4k3/8/8/8/8/8/4P3/4K2R b K - 5 20")};
+    ASSERT_EQ(b.getHalfmoveClock(), 5);
+    ASSERT_EQ(b.getFullmoveNumber(), 20);
+
+    b.move(Move(SQUARE(0, 4), SQUARE(0, 3))); // Kd8
+    ASSERT_EQ(b.getFen(), "3k4/8/8/8/8/8/4P3/4K2R w K - 6 21");
+    b.move(Move(SQUARE(6, 4), SQUARE(4, 4), Move::DOUBLE_PUSH)); // e4 resets the clock
+    ASSERT_EQ(b.getFen(), "3k4/8/8/8/4P3/8/8/4K2R b K e3 0 21");
+    b.undo();
+    b.undo();
+    ASSERT_EQ(b.getFen(), "4k3/8/8/8/8/8/4P3/4K2R b K - 5 20");
+}
+
+TEST(fen, invalid_and_partial)
+{
+    Board b;
+    ASSERT_FALSE(b.setFen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP w KQkq - 0 1")); // a row short
+    ASSERT_FALSE(b.setFen("rnbqkbnr/ppppxppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"));
+    ASSERT_FALSE(b.setFen(""));
+    ASSERT_EQ(b.getBitboards().occupied(), 0);
+
+    // en passant only on the square a pawn of the other side just skipped
+    ASSERT_FALSE(b.setFen("4k3/8/8/8/8/8/3PP3/4K3 w - e3 0 1")); // behind our own pawn
+    ASSERT_EQ(b.getEnPassantSquare(), -1);
+    ASSERT_FALSE(b.setFen("4k3/8/8/4p3/8/8/8/4K3 b - e6 0 1")); // the wrong side to move
+    ASSERT_FALSE(b.setFen("4k3/8/8/8/8/8/8/4K3 w - e6 0 1"));   // no pawn went past it
+    ASSERT_TRUE(b.setFen("4k3/8/8/3Pp3/8/8/8/4K3 w - e6 0 1"));
+    ASSERT_EQ(b.getEnPassantSquare(), SQUARE(2, 4));
+    ASSERT_TRUE(b.setFen("4k3/8/8/8/4P3/8/8/4K3 b - e3 0 1"));
+
+    // clocks too big for the board are held at their limits instead of overflowing
+    ASSERT_TRUE(b.setFen("4k3/8/8/8/8/8/8/4K3 w - - 70000 99999999999"));
+    ASSERT_EQ(b.getHalfmoveClock(), 10000);
+    ASSERT_EQ(b.getFullmoveNumber(), 100000);
+
+    // EPD: no clocks, the operations start where the position ends
+    size_t end = 0;
+    std::string epd = "4k3/8/8/8/8/8/8/4K3 b - - bm Kd7; id \"kings\";";
+    ASSERT_TRUE(b.setFen(epd, &end));
+    ASSERT_EQ(b.getPlayerToMove(), PlayerColor::Black);
+    ASSERT_EQ(b.getFullmoveNumber(), 1);
+    ASSERT_EQ(epd.substr(end), " bm Kd7; id \"kings\";");
+}
+
+TEST(fen, epd_reader_streams_positions)
+{
+    const char *path = "fen_epd_reader_test.epd";
+    {
+        std::ofstream file(path);
+        file << "# a comment, then a blank line\n\n"
+             << "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1 ;D1 20 ;D2 400\r\n"
+             << "not a position\n"
+             << "4k3/8/8/8/8/8/8/4K3 w - - bm Kd2;"; // no newline at the end
+    }
+
+    EpdReader reader(path);
+    ASSERT_TRUE(reader.isOpen());
+    Board b;
+    ASSERT_TRUE(reader.next(b));
+    ASSERT_EQ(b.getFen(), "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+    ASSERT_EQ(reader.operations(), ";D1 20 ;D2 400");
+    ASSERT_TRUE(reader.next(b));
+    ASSERT_EQ(b.getFen(), "4k3/8/8/8/8/8/8/4K3 w - - 0 1");
+    ASSERT_EQ(reader.operations(), "bm Kd2;");
+    ASSERT_FALSE(reader.next(b));
+    ASSERT_EQ(reader.invalidLines(), 1);
+    ASSERT_EQ(reader.lineNumber(), 5);
+
+    std::remove(path);
+}
@@ -0,0 +1,84 @@
+#include "gtest/gtest.h"
+#include "Board.h"
+#include "Match.h"
+#include "Pgn.h"
+
+TEST(match, parses_engine_configs)
+{
+    match::EngineConfig config;
+    ASSERT_TRUE(match::parseEngine("name=fast,nodes=5000,hash=4", config));
+    ASSERT_EQ(config.m_name, "fast");
+    ASSERT_EQ(config.m_limits.m_nodes, 5000u);
+    ASSERT_EQ(config.m_hashMb, 4u);
+
+    ASSERT_TRUE(match::parseEngine("tc=10+0.1", config));
+    ASSERT_EQ(config.m_name, "tc=10+0.1");
+    ASSERT_EQ(config.m_clockMs, 10000);
+    ASSERT_EQ(config.m_incrementMs, 100);
+
+    // no limit would search forever
+    ASSERT_FALSE(match::parseEngine("name=slow", config));
+    ASSERT_FALSE(match::parseEngine("depth=3,speed=11", config));
+}
+
+TEST(match, plays_games_to_the_end)
+{
+    match::EngineConfig config;
+    ASSERT_TRUE(match::parseEngine("depth=2,hash=1", config));
+    search::ThreadedSearch white(1), black(1);
+    match::Adjudication adjudication;
+
+    match::GameRecord game = match::playGame("6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1", config, config, white, black, adjudication);
+    ASSERT_TRUE(game.m_outcome == match::Outcome::WhiteWins);
+    ASSERT_EQ(game.m_reason, "checkmate");
+    ASSERT_EQ(game.m_moves.size(), 1u);
+    ASSERT_EQ(game.m_scores.size(), 1u);
+    ASSERT_GE(game.m_scores[0], search::MATE_BOUND);
+
+    game = match::playGame("8/8/4k3/8/8/3NK3/8/8 w - - 0 1", config, config, white, black, adjudication);
+    ASSERT_TRUE(game.m_outcome == match::Outcome::Draw);
+    ASSERT_EQ(game.m_reason, "insufficient material");
+
+    // kings and rooks shuffle until one of the draw rules ends it
+    adjudication.m_maxPlies = 40;
+    game = match::playGame("r3k3/8/8/8/8/8/8/R3K3 w - - 0 1", config, config, white, black, adjudication);
+    ASSERT_TRUE(game.m_outcome == match::Outcome::Draw);
+    ASSERT_LE(game.m_moves.size(), 40u);
+
+    // what's written out reads back as the same game
+    const std::string text = match::toPgn(game, "a", "b", 1);
+    pgn::Reader reader(text);
+    pgn::Game read;
+    Board board;
+    ASSERT_TRUE(reader.next(read));
+    ASSERT_EQ(read.tag("Result"), "1/2-1/2");
+    ASSERT_EQ(pgn::replay(read, board), static_cast<int>(game.m_moves.size()));
+}
+
+TEST(match, elo_and_error_bars)
+{
+    ASSERT_DOUBLE_EQ(match::elo(0.5), 0);
+    ASSERT_NEAR(match::elo(0.75), 190.85, 0.01);
+    ASSERT_NEAR(match::elo(0.25), -190.85, 0.01);
+
+    match::Score few{6, 4, 10};
+    match::Score many{600, 400, 1000};
+    ASSERT_DOUBLE_EQ(few.ratio(), many.ratio());
+    ASSERT_GT(match::eloError(few), 5 * match::eloError(many));
+    ASSERT_NEAR(match::eloError(many), 10.8, 0.1);
+}
+
+TEST(match, sprt_decides)
+{
+    match::Sprt test;
+    test.m_elo0 = 0;
+    test.m_elo1 = 10;
+    ASSERT_NEAR(test.upperBound(), 2.944, 0.001);
+    ASSERT_NEAR(test.lowerBound(), -2.944, 0.001);
+
+    ASSERT_TRUE(test.decide(match::Score{6, 4, 10}) == match::Sprt::Decision::Continue);
+    ASSERT_TRUE(test.decide(match::Score{600, 400, 1000}) == match::Sprt::Decision::AcceptH1);
+    ASSERT_TRUE(test.decide(match::Score{400, 600, 1000}) == match::Sprt::Decision::AcceptH0);
+    // at exactly halfway between the hypotheses neither is more likely
+    ASSERT_NEAR(test.llr(match::Score{0, 0, 10}), 0, 1e-9);
+}
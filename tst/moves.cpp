@@ -1,6 +1,9 @@
 #include "gtest/gtest.h"
 #include "Board.h"
 #include "Piece.h"
+#include <algorithm>
+#include <iterator>
+#include <random>
 #include <vector>
 
 TEST(moves, queen) // also tests rook / bishop LOL
@@ -38,11 +41,11 @@ TEST(moves, queen) // also tests rook / bishop LOL
     Board b{pieces};
 
     b.setValidMoves(std::pair<int, int>{7, 3});
-    const std::vector<Move> &moves = b.getValidMoves();
+    const MoveList &moves = b.getValidMoves();
 
     for (auto &move : moves)
     {
-        auto it = std::find(std::begin(expected), std::end(expected), move.m_dest);
+        auto it = std::find(std::begin(expected), std::end(expected), move.destPosition());
         ASSERT_TRUE(it != std::end(expected));
     }
 
@@ -55,7 +58,7 @@ TEST(moves, queen) // also tests rook / bishop LOL
 
     for (auto &move : moves)
     {
-        auto it = std::find(std::begin(unexpected), std::end(unexpected), move.m_dest);
+        auto it = std::find(std::begin(unexpected), std::end(unexpected), move.destPosition());
         ASSERT_TRUE(it == std::end(unexpected));
     }
 }
@@ -189,11 +192,11 @@ TEST(moves, king_moves_next_to_king)
     Board b{pieces};
 
     b.setValidMoves(std::pair<int, int>{2, 0});
-    const std::vector<Move> &moves = b.getValidMoves();
+    const MoveList &moves = b.getValidMoves();
 
     for (auto &move : moves)
     {
-        auto it = std::find(std::begin(expected), std::end(expected), move.m_dest);
+        auto it = std::find(std::begin(expected), std::end(expected), move.destPosition());
         ASSERT_TRUE(it != std::end(expected));
     }
 
@@ -204,7 +207,7 @@ TEST(moves, king_moves_next_to_king)
 
     for (auto &move : moves)
     {
-        auto it = std::find(std::begin(unexpected), std::end(unexpected), move.m_dest);
+        auto it = std::find(std::begin(unexpected), std::end(unexpected), move.destPosition());
         ASSERT_TRUE(it == std::end(unexpected));
     }
 }
@@ -228,13 +231,13 @@ TEST(moves, king_castles_queenside)
     Board b{pieces};
 
     b.setValidMoves(std::pair<int, int>{7, 4});
-    const std::vector<Move> &moves = b.getValidMoves();
+    const MoveList &moves = b.getValidMoves();
 
     bool targetFound = false;
     // find the move !!
     for (auto it = moves.begin(); it != moves.end(); it++)
     {
-        if (it->m_dest == std::pair<int, int>{7, 2}) // queenside castle
+        if (it->destPosition() == std::pair<int, int>{7, 2}) // queenside castle
         {
             targetFound = true;
             b.move(*it);
@@ -244,4 +247,145 @@ TEST(moves, king_castles_queenside)
     ASSERT_TRUE(targetFound);
     // assert that rook also moves
     ASSERT_TRUE(b.getBoard()[7][3] == Piece::WHITE_ROOK);
-}
\ No newline at end of file
+}
+TEST(moves, pinned_pieces)
+{
+    // the knight on e2 is pinned by the rook, the bishop on d2 by the queen (it can slide towards her but not off the diagonal)
+    Board b{std::string("4r3/8/8/q7/8/8/3BN3/4K3 w - - 0 1")};
+
+    b.setValidMoves({6, 4}); // knight
+    ASSERT_TRUE(b.getValidMoves().empty());
+
+    b.setValidMoves({6, 3}); // bishop
+    std::vector<std::pair<int, int>> expected{{5, 2}, {4, 1}, {3, 0}};
+    ASSERT_EQ(b.getValidMoves().size(), expected.size());
+    for (auto &move : b.getValidMoves())
+    {
+        auto it = std::find(std::begin(expected), std::end(expected), move.destPosition());
+        ASSERT_TRUE(it != std::end(expected));
+    }
+}
+
+TEST(moves, block_check)
+{
+    // the rook on h1 checks along the back row and the b2 rook covers the second row,
+    // so the only replies are the two ways of blocking on f1
+    Board b{std::string("5R2/8/k7/8/8/4N3/1r6/4K2r w - - 0 1")};
+    MoveList moves;
+    b.getLegalMoves(moves);
+
+    ASSERT_EQ(moves.size(), 2);
+    for (auto &move : moves)
+    {
+        ASSERT_TRUE(move.destPosition() == (std::pair<int, int>{7, 5}));
+    }
+}
+
+TEST(moves, packed_encoding)
+{
+    ASSERT_EQ(sizeof(Move), 2);
+    ASSERT_TRUE(Move().isNull());
+
+    // e7 (row 1) to d8 (row 0), taking and promoting to a knight
+    Move move(SQUARE(1, 4), SQUARE(0, 3), Move::KNIGHT_PROMOTION_CAPTURE);
+    ASSERT_EQ(move.start(), SQUARE(1, 4));
+    ASSERT_EQ(move.dest(), SQUARE(0, 3));
+    ASSERT_TRUE(move.isCapture() && move.isPromotion() && !move.isCastling());
+    ASSERT_TRUE(move.promotion() == Piece::WHITE_KNIGHT);
+    ASSERT_EQ(move.toString(), "e7d8n");
+    ASSERT_TRUE(Move::fromRaw(move.raw()) == move);
+
+    // generation doesn't need more than the fixed list holds, and undo puts the captured piece back
+    Board b{std::string("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1")};
+    MoveList moves;
+    b.getLegalMoves(moves);
+    ASSERT_EQ(moves.size(), 48);
+    Move takesKnight(SQUARE(5, 5), SQUARE(2, 5), Move::CAPTURE); // Qf3xf6
+    ASSERT_TRUE(std::find(moves.begin(), moves.end(), takesKnight) != moves.end());
+    b.move(takesKnight);
+    b.undo();
+    ASSERT_TRUE(b.getBoard()[2][5] == Piece::BLACK_KNIGHT);
+}
+
+TEST(moves, captures_only)
+{
+    // the captures and promotions of the full list, in the same order, through random games
+    std::mt19937 generator(585);
+    for (const std::string fen : {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+                                  "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8"})
+    {
+        Board b{fen};
+        for (int played = 0; played < 100; played++)
+        {
+            MoveList moves, captures;
+            b.getLegalMoves(moves);
+            b.getLegalCaptures(captures);
+            if (moves.empty())
+                break;
+            std::vector<Move> expected;
+            std::copy_if(moves.begin(), moves.end(), std::back_inserter(expected),
+                         [](const Move &move) { return move.isCapture() || move.isPromotion(); });
+            ASSERT_EQ(std::vector<Move>(captures.begin(), captures.end()), expected) << b.getFen();
+            b.move(moves[generator() % moves.size()]);
+        }
+    }
+}
+
+TEST(moves, undo_restores_irreversible_state)
+{
+    Board b{std::string("r3k2r/8/8/8/3p4/8/4P3/R3K2R w KQkq - 0 1")};
+    const uint64_t hash = b.getHash();
+
+    b.move(Move(SQUARE(7, 0), SQUARE(7, 1))); // Rb1: white loses queenside castling
+    b.move(Move(SQUARE(0, 4), SQUARE(0, 3))); // Kd8: black loses both
+    ASSERT_EQ(b.getCastlingRights(), CastlingRights::WHITE_KINGSIDE);
+    ASSERT_EQ(b.getHalfmoveClock(), 2);
+
+    b.move(Move(SQUARE(6, 4), SQUARE(4, 4), Move::DOUBLE_PUSH)); // e4, and d4 can take it in passing
+    ASSERT_EQ(b.getEnPassantSquare(), SQUARE(5, 4));
+    ASSERT_EQ(b.getHalfmoveClock(), 0);
+    b.move(Move(SQUARE(4, 3), SQUARE(5, 4), Move::EN_PASSANT));
+    ASSERT_EQ(b.getEnPassantSquare(), -1);
+
+    for (int i = 0; i < 4; i++)
+        b.undo();
+    ASSERT_EQ(b.getCastlingRights(), CastlingRights::ALL_CASTLING);
+    ASSERT_EQ(b.getEnPassantSquare(), -1);
+    ASSERT_EQ(b.getHalfmoveClock(), 0);
+    ASSERT_EQ(b.getHash(), hash);
+    ASSERT_TRUE(b.getBoard()[6][4] == Piece::WHITE_PAWN);
+    ASSERT_TRUE(b.getBoard()[4][3] == Piece::BLACK_PAWN);
+}
+
+TEST(moves, cached_legal_moves)
+{
+    Board b;
+    const MoveList *cached = &b.legalMoves();
+    ASSERT_EQ(cached->size(), 20);
+    // asked again in the same position, it's the same list
+    ASSERT_EQ(&b.legalMoves(), cached);
+    b.select(7, 6); // g1 knight
+    ASSERT_EQ(b.getValidMoves().size(), 2);
+    b.select(6, 4); // e2 pawn
+    ASSERT_EQ(b.getValidMoves().size(), 2);
+
+    b.move(b.getValidMoves()[0]);
+    ASSERT_EQ(b.legalMoves().size(), 20);
+    ASSERT_EQ(getPieceColor(b.getBitboards().at(b.legalMoves()[0].start())), PlayerColor::Black);
+    b.undo();
+    ASSERT_EQ(getPieceColor(b.getBitboards().at(b.legalMoves()[0].start())), PlayerColor::White);
+    b.setFen("4k3/8/8/8/8/8/8/4K2R w K - 0 1");
+    ASSERT_EQ(b.legalMoves().size(), 15);
+
+    // in check with the king boxed in, but the rook can take the checker: not mate
+    Board defended{std::string("6k1/5ppp/8/8/8/8/5PPP/R3r1K1 w - - 0 1")};
+    ASSERT_FALSE(defended.isCheckmate(PlayerColor::Black));
+    Board mate{std::string("4r1k1/5ppp/8/8/8/8/5PPP/4r1K1 w - - 0 1")};
+    ASSERT_TRUE(mate.isCheckmate(PlayerColor::Black));
+    ASSERT_FALSE(mate.isCheckmate(PlayerColor::White));
+    ASSERT_FALSE(mate.isStalemate());
+
+    Board stalemate{std::string("7k/5Q2/6K1/8/8/8/8/8 b - - 0 1")};
+    ASSERT_TRUE(stalemate.isStalemate());
+    ASSERT_FALSE(stalemate.isCheckmate(PlayerColor::White));
+}
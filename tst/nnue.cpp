@@ -0,0 +1,167 @@
+#include "gtest/gtest.h"
+#include "Board.h"
+#include "Evaluate.h"
+#include "Nnue.h"
+
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <random>
+
+namespace
+{
+    const char *NETWORK_PATH = "nnue_test.nnue";
+
+    // no trained network ships with the engine, so the tests make up a small weighted one
+    nnue::Weights randomWeights(unsigned seed)
+    {
+        std::mt19937 generator(seed);
+        auto fill = [&](auto &values, int range) {
+            for (auto &value : values)
+                value = static_cast<std::remove_reference_t<decltype(value)>>(static_cast<int>(generator() % (2 * range + 1)) - range);
+        };
+        nnue::Weights weights;
+        fill(weights.m_hiddenBiases, 64);
+        fill(weights.m_hiddenWeights, 32);
+        fill(weights.m_l1Biases, 256);
+        fill(weights.m_l1Weights, 24);
+        fill(weights.m_l2Biases, 256);
+        fill(weights.m_l2Weights, 48);
+        fill(weights.m_outputWeights, 64);
+        weights.m_outputBias = 100;
+        return weights;
+    }
+
+    // the same position with the board turned around and the colours swapped (no en passant square)
+    std::string mirror(const std::string &fen)
+    {
+        std::string placement = fen.substr(0, fen.find(' '));
+        std::string rest = fen.substr(fen.find(' ') + 1);
+        std::string ranks;
+        size_t end = placement.size();
+        while (true)
+        {
+            size_t start = placement.rfind('/', end - 1);
+            start = start == std::string::npos ? 0 : start + 1;
+            ranks += placement.substr(start, end - start);
+            if (start == 0)
+                break;
+            ranks += '/';
+            end = start - 1;
+        }
+        for (char &c : ranks)
+            c = std::isupper(c) ? std::tolower(c) : std::toupper(c);
+        rest[0] = rest[0] == 'w' ? 'b' : 'w';
+        for (size_t i = 2; i < rest.size() && rest[i] != ' '; i++)
+            rest[i] = std::isupper(rest[i]) ? std::tolower(rest[i]) : std::toupper(rest[i]);
+        return ranks + " " + rest;
+    }
+}
+
+TEST(nnue, kernels_agree)
+{
+    std::mt19937 generator(585);
+    const nnue::Kernels *scalar = nnue::kernelsFor(nnue::Isa::Scalar);
+    ASSERT_TRUE(scalar != nullptr);
+
+    std::vector<int16_t> weights(nnue::HIDDEN), accumulator(nnue::HIDDEN);
+    std::vector<uint8_t> activations(512);
+    std::vector<int8_t> layer(512);
+    for (auto &w : weights)
+        w = static_cast<int16_t>(generator() % 2001) - 1000;
+    for (auto &a : accumulator)
+        a = static_cast<int16_t>(generator() % 801) - 400;
+    for (auto &a : activations)
+        a = static_cast<uint8_t>(generator() % (nnue::ACTIVATION_MAX + 1));
+    for (auto &w : layer)
+        w = static_cast<int8_t>(generator() % 256);
+
+    for (nnue::Isa isa : {nnue::Isa::Sse41, nnue::Isa::Avx2})
+    {
+        const nnue::Kernels *kernels = nnue::kernelsFor(isa);
+        if (!kernels)
+            continue;
+
+        std::vector<int16_t> expected = accumulator, actual = accumulator;
+        scalar->m_addFeature(expected.data(), weights.data());
+        kernels->m_addFeature(actual.data(), weights.data());
+        ASSERT_EQ(expected, actual) << kernels->m_name;
+        scalar->m_subFeature(expected.data(), weights.data());
+        kernels->m_subFeature(actual.data(), weights.data());
+        ASSERT_EQ(expected, actual) << kernels->m_name;
+
+        std::vector<uint8_t> expectedRelu(nnue::HIDDEN), actualRelu(nnue::HIDDEN);
+        scalar->m_clippedRelu(accumulator.data(), expectedRelu.data(), nnue::HIDDEN);
+        kernels->m_clippedRelu(accumulator.data(), actualRelu.data(), nnue::HIDDEN);
+        ASSERT_EQ(expectedRelu, actualRelu) << kernels->m_name;
+
+        for (int size : {32, 512})
+            ASSERT_EQ(scalar->m_dot(activations.data(), layer.data(), size), kernels->m_dot(activations.data(), layer.data(), size)) << kernels->m_name;
+    }
+}
+
+TEST(nnue, incremental_matches_refresh)
+{
+    ASSERT_TRUE(nnue::save(NETWORK_PATH, randomWeights(585)));
+    ASSERT_TRUE(nnue::load(NETWORK_PATH));
+    ASSERT_TRUE(nnue::isLoaded());
+
+    std::mt19937 generator(585);
+    // castling both ways and a promotion with capture available
+    for (const std::string fen : {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+                                  "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8"})
+    {
+        Board b{fen};
+        std::vector<int> evaluations{nnue::evaluate(b)};
+        int played = 0;
+        for (; played < 60; played++)
+        {
+            MoveList moves;
+            b.getLegalMoves(moves);
+            if (moves.empty())
+                break;
+            b.move(moves[generator() % moves.size()]);
+            // skip evaluating some plies, so the accumulator has to catch up over several moves
+            if (generator() % 3 == 0)
+            {
+                b.makeNullMove();
+                b.undo();
+            }
+            if (generator() % 2 == 0)
+            {
+                ASSERT_EQ(nnue::evaluate(b), nnue::evaluate(Board{b.getFen()})) << b.getFen();
+            }
+            evaluations.push_back(nnue::evaluate(b));
+        }
+        for (; played > 0; played--)
+        {
+            b.undo();
+            evaluations.pop_back();
+            ASSERT_EQ(nnue::evaluate(b), evaluations.back()) << b.getFen();
+        }
+    }
+
+    // the network sees the position the same way from either side
+    for (const std::string fen : {"r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4",
+                                  "8/2k5/3p4/p2P1p2/P2P1P2/8/5K2/8 b - - 0 40"})
+        ASSERT_EQ(nnue::evaluate(Board{fen}), nnue::evaluate(Board{mirror(fen)})) << fen;
+
+    // the network takes over from the piece-square evaluation while it's loaded
+    Board start;
+    ASSERT_EQ(eval::evaluate(start), nnue::evaluate(start));
+    nnue::unload();
+    ASSERT_FALSE(nnue::isLoaded());
+    std::remove(NETWORK_PATH);
+}
+
+TEST(nnue, rejects_bad_files)
+{
+    ASSERT_FALSE(nnue::load("no_such_network.nnue"));
+    {
+        std::ofstream file(NETWORK_PATH, std::ios::binary);
+        file << "CPSCNNUE but far too short";
+    }
+    ASSERT_FALSE(nnue::load(NETWORK_PATH));
+    ASSERT_FALSE(nnue::isLoaded());
+    std::remove(NETWORK_PATH);
+}
@@ -0,0 +1,93 @@
+#include "gtest/gtest.h"
+#include "Board.h"
+#include "Evaluate.h"
+#include "Pawns.h"
+#include "Pgn.h"
+
+#include <utility>
+#include <vector>
+
+TEST(pawns, key_changes_with_the_pawns)
+{
+    // a push, en passant, a piece taking a pawn, castling, a promotion and a piece taking a piece.
+    // (the zobrist random games check the key against one worked out from scratch)
+    const std::vector<std::pair<const char *, bool>> moves = {{"d5", true}, {"exd6", true}, {"Kxd6", true},
+                                                               {"O-O", false}, {"b1=Q", true}, {"Raxb1", false}};
+    Board board{std::string("8/3pk3/8/4P3/8/8/1p6/R3K2R b KQ - 0 1")};
+    for (const auto &[san, changes] : moves)
+    {
+        const uint64_t before = board.getPawnHash();
+        Move move = pgn::parseSan(board, san);
+        ASSERT_FALSE(move.isNull()) << san;
+        board.move(move);
+        ASSERT_EQ(board.getPawnHash() != before, changes) << san;
+    }
+    // no pawns left
+    ASSERT_EQ(board.getPawnHash(), 0u);
+}
+
+TEST(pawns, structure)
+{
+    // white: a passed pawn on d5, doubled pawns on the g file, and an isolated one on a2. black: f6 and h7
+    Board board{std::string("4k3/7p/5p2/3P4/8/6P1/P5P1/4K3 w - - 0 1")};
+    const Bitboards &bitboards = board.getBitboards();
+    eval::PawnEntry entry = eval::evaluatePawns(bitboards.pieces(Piece::WHITE_PAWN), bitboards.pieces(Piece::BLACK_PAWN));
+    // a2 has no pawn in front of it either
+    ASSERT_EQ(entry.m_passed[PlayerColor::White], SQUARE_BB(SQUARE(3, 3)) | SQUARE_BB(SQUARE(6, 0)));
+    ASSERT_EQ(entry.m_passed[PlayerColor::Black], 0);
+
+    // the same pawns flipped top to bottom and with the colours swapped score the same the other way round
+    Board flipped{std::string("4k3/p5p1/6p1/8/3p4/5P2/7P/4K3 b - - 0 1")};
+    const Bitboards &other = flipped.getBitboards();
+    eval::PawnEntry mirror = eval::evaluatePawns(other.pieces(Piece::WHITE_PAWN), other.pieces(Piece::BLACK_PAWN));
+    ASSERT_TRUE(mirror.m_score == -entry.m_score);
+    ASSERT_EQ(eval::evaluate(board), eval::evaluate(flipped));
+
+    // a king behind its pawns is better off than one that has lost them
+    Board sheltered{std::string("6k1/5ppp/8/8/8/8/5PPP/6K1 w - - 0 1")};
+    Board exposed{std::string("6k1/5ppp/8/8/8/8/PPP5/6K1 w - - 0 1")};
+    const eval::PawnEntry shield = eval::evaluatePawns(sheltered.getBitboards().pieces(Piece::WHITE_PAWN), 0);
+    const eval::PawnEntry none = eval::evaluatePawns(exposed.getBitboards().pieces(Piece::WHITE_PAWN), 0);
+    ASSERT_GT(shield.m_shield[PlayerColor::White][6], none.m_shield[PlayerColor::White][6]);
+}
+
+TEST(pawns, table_hits)
+{
+    eval::PawnTable table(64);
+    Board board;
+    const int uncached = eval::evaluate(board);
+    ASSERT_EQ(eval::evaluate(board, &table), uncached);
+    ASSERT_EQ(table.probes(), 1u);
+    ASSERT_EQ(table.hits(), 0u);
+
+    // a knight move leaves the pawns where they were
+    board.move(Move(SQUARE(7, 6), SQUARE(5, 5)));
+    eval::evaluate(board, &table);
+    board.undo();
+    ASSERT_EQ(eval::evaluate(board, &table), uncached);
+    ASSERT_EQ(table.probes(), 3u);
+    ASSERT_EQ(table.hits(), 2u);
+
+    // no pawns at all has a key of 0, the same as an empty slot
+    Board kings{std::string("4k3/8/8/8/8/8/8/4K3 w - - 0 1")};
+    ASSERT_EQ(kings.getPawnHash(), 0u);
+    eval::PawnTable fresh(64);
+    ASSERT_EQ(eval::evaluate(kings, &fresh), eval::evaluate(kings));
+}
+
+TEST(pawns, positions_without_a_king)
+{
+    // setFen takes them: the pawn terms still count, the ones about the kings are left out
+    eval::PawnTable table(64);
+    for (const char *fen : {"8/8/8/8/4P3/8/8/4K3 w - - 0 1", "4k3/8/8/8/4P3/8/8/8 w - - 0 1", "8/3p4/8/8/4P3/8/8/8 b - - 0 1"})
+    {
+        Board board{std::string(fen)};
+        const Bitboards &bitboards = board.getBitboards();
+        const eval::Score pawns = eval::evaluatePawns(bitboards.pieces(Piece::WHITE_PAWN), bitboards.pieces(Piece::BLACK_PAWN)).m_score;
+        const eval::Score expected = board.getPsq() + pawns;
+        // no pieces: all endgame, from the side to move's point of view, plus the tempo
+        const int sign = board.getPlayerToMove() == PlayerColor::White ? 1 : -1;
+        ASSERT_EQ(eval::evaluate(board), sign * expected.m_eg + 10) << fen;
+        ASSERT_EQ(eval::evaluate(board, &table), eval::evaluate(board)) << fen;
+    }
+}
@@ -0,0 +1,90 @@
+#include "gtest/gtest.h"
+#include "Board.h"
+#include "Perft.h"
+
+TEST(perft, start_position)
+{
+    Board b;
+    ASSERT_EQ(perft::perft(b, 1), 20);
+    ASSERT_EQ(perft::perft(b, 3), 8902);
+}
+
+TEST(perft, kiwipete)
+{
+    // castling, en passant and promotions all show up by depth 2
+    Board b{std::string("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1")};
+    ASSERT_EQ(perft::perft(b, 2), 2039);
+}
+
+TEST(perft, undo_restores_castling_rook)
+{
+    Board b{std::string("r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1")};
+    MoveList moves;
+    b.getLegalMoves(moves);
+
+    for (const Move &move : moves)
+    {
+        if (!move.isCastling())
+            continue;
+        b.move(move);
+        b.undo();
+        ASSERT_TRUE(b.getBoard()[7][0] == Piece::WHITE_ROOK);
+        ASSERT_TRUE(b.getBoard()[7][7] == Piece::WHITE_ROOK);
+        ASSERT_TRUE(b.getBoard()[7][4] == Piece::WHITE_KING);
+        ASSERT_TRUE(b.getBoard()[7][3] == Piece::EMPTY);
+        ASSERT_TRUE(b.getBoard()[7][5] == Piece::EMPTY);
+    }
+}
+
+TEST(perft, en_passant_and_promotion)
+{
+    // white can take d5 in passing, black's b2 pawn promotes
+    Board b{std::string("4k3/8/8/3pP3/8/8/1p6/4K3 w - d6 0 1")};
+    MoveList moves;
+    b.getLegalMoves(moves);
+    auto inPassing = std::find_if(moves.begin(), moves.end(), [](const Move &m) { return m.isEnPassant(); });
+    ASSERT_TRUE(inPassing != moves.end());
+    ASSERT_EQ(inPassing->toString(), "e5d6");
+
+    b.move(*inPassing);
+    ASSERT_TRUE(b.getBoard()[3][3] == Piece::EMPTY); // the taken pawn is gone
+    moves.clear();
+    b.getLegalMoves(moves);
+    int promotions = std::count_if(moves.begin(), moves.end(), [](const Move &m) { return m.isPromotion(); });
+    ASSERT_EQ(promotions, 4);
+
+    b.undo();
+    ASSERT_TRUE(b.getBoard()[3][3] == Piece::BLACK_PAWN);
+}
+
+TEST(perft, parallel_matches_serial)
+{
+    for (const char *fen : {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+                            "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1"})
+    {
+        Board b{std::string(fen)};
+        const uint64_t serial = perft::perft(b, 4);
+        perft::PerftTable table(4);
+
+        for (int threads : {1, 3})
+        {
+            perft::ParallelResult plain = perft::parallelPerft(b, 4, threads);
+            perft::ParallelResult hashed = perft::parallelPerft(b, 4, threads, &table);
+            ASSERT_EQ(plain.m_nodes, serial);
+            ASSERT_EQ(hashed.m_nodes, serial);
+            ASSERT_EQ(plain.m_threads.size(), static_cast<size_t>(threads));
+
+            // every subtree below the first two plies is counted by exactly one thread
+            uint64_t tasks = 0, nodes = 0;
+            for (const perft::ThreadStats &stats : plain.m_threads)
+            {
+                tasks += stats.m_tasks;
+                nodes += stats.m_nodes;
+            }
+            ASSERT_EQ(tasks, perft::perft(b, 2));
+            ASSERT_EQ(nodes, serial);
+        }
+        ASSERT_EQ(perft::perft(b, 4, table), serial);
+        ASSERT_EQ(b.getFen(), fen);
+    }
+}
@@ -0,0 +1,167 @@
+#include "gtest/gtest.h"
+#include "Board.h"
+#include "Pgn.h"
+
+#include <random>
+#include <string>
+
+// random games written out the way a database would have them
+static std::string randomGames(int games, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    Board board;
+    std::string text;
+    for (int game = 0; game < games; game++)
+    {
+        board.setFen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+        text += "[Event \"random " + std::to_string(game) + "\"]\n[Result \"*\"]\n\n";
+        for (int ply = 0; ply < 100; ply++)
+        {
+            MoveList moves;
+            board.getLegalMoves(moves);
+            if (moves.empty())
+                break;
+            Move move = moves[rng() % moves.size()];
+            if (ply % 2 == 0)
+                text += std::to_string(ply / 2 + 1) + ". ";
+            text += pgn::toSan(board, move) + (ply % 8 == 7 ? "\n" : " ");
+            board.move(move);
+        }
+        text += "*\n\n";
+    }
+    return text;
+}
+
+TEST(pgn, san_round_trip)
+{
+    std::mt19937 rng(7);
+    for (const char *fen : {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+                            "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+                            "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1"})
+    {
+        Board board{std::string(fen)};
+        for (int ply = 0; ply < 60; ply++)
+        {
+            MoveList moves;
+            board.getLegalMoves(moves);
+            if (moves.empty())
+                break;
+            for (const Move &move : moves)
+            {
+                std::string san = pgn::toSan(board, move);
+                ASSERT_TRUE(pgn::parseSan(board, san) == move) << san << " in " << board.getFen();
+            }
+            board.move(moves[rng() % moves.size()]);
+        }
+    }
+}
+
+TEST(pgn, san_details)
+{
+    // knights on b1 and f3 can both go to d2, the rooks on a1 and a5 both to a3
+    Board board{std::string("4k3/8/8/R7/8/8/8/RN2K1N1 w Q - 0 1")};
+    board.move(pgn::parseSan(board, "Nf3"));
+    board.move(pgn::parseSan(board, "Ke7"));
+    ASSERT_TRUE(pgn::parseSan(board, "Nd2").isNull());
+    ASSERT_EQ(pgn::parseSan(board, "Nbd2").toString(), "b1d2");
+    ASSERT_EQ(pgn::parseSan(board, "Nf3d2").toString(), "f3d2");
+    ASSERT_EQ(pgn::toSan(board, pgn::parseSan(board, "Nfd2")), "Nfd2");
+    ASSERT_EQ(pgn::toSan(board, pgn::parseSan(board, "R1a3")), "R1a3");
+    ASSERT_EQ(pgn::toSan(board, pgn::parseSan(board, "Ra7+")), "Ra7+");
+    ASSERT_TRUE(pgn::parseSan(board, "Nc4").isNull());
+    ASSERT_TRUE(pgn::parseSan(board, "Rb9").isNull());
+
+    Board promotion{std::string("3q3k/4P3/8/8/8/8/8/K7 w - - 0 1")};
+    ASSERT_EQ(pgn::parseSan(promotion, "exd8=N").toString(), "e7d8n");
+    ASSERT_EQ(pgn::parseSan(promotion, "e8Q!").toString(), "e7e8q");
+    ASSERT_TRUE(pgn::parseSan(promotion, "e8").isNull());
+    ASSERT_EQ(pgn::toSan(promotion, pgn::parseSan(promotion, "exd8=Q")), "exd8=Q+");
+}
+
+TEST(pgn, reads_annotated_games)
+{
+    const std::string text =
+        "[Event \"annotated\"]\n"
+        "[White \"Someone \\\"Quoted\\\"\"]\n"
+        "\n"
+        "1. e4 {best by test} e5 $1 2. Nf3 (2. f4 exf4 (2... d5) 3. Nf3) 2...Nc6 { a comment\n"
+        "[%clk 0:03:00] } 3.Bb5 ; to the end of the line\n"
+        "a6!? 4. Ba4 1/2-1/2\n"
+        "\n"
+        "[Event \"from a position\"]\n"
+        "[SetUp \"1\"]\n"
+        "[FEN \"6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1\"]\n"
+        "\n"
+        "1. Ra8# 1-0\n";
+
+    pgn::Reader reader(text);
+    pgn::Game game;
+    Board board;
+    std::string error;
+
+    ASSERT_TRUE(reader.next(game));
+    ASSERT_EQ(game.m_offset, 0u);
+    ASSERT_EQ(game.tag("Event"), "annotated");
+    ASSERT_EQ(game.tag("White"), "Someone \\\"Quoted\\\"");
+    ASSERT_EQ(game.tag("Black"), "");
+    ASSERT_EQ(pgn::replay(game, board, &error), 7) << error;
+    ASSERT_EQ(board.getFen(), "r1bqkbnr/1ppp1ppp/p1n5/4p3/B3P3/5N2/PPPP1PPP/RNBQK2R b KQkq - 1 4");
+
+    ASSERT_TRUE(reader.next(game));
+    ASSERT_EQ(game.tag("Event"), "from a position");
+    ASSERT_EQ(pgn::replay(game, board, &error), 1) << error;
+    ASSERT_TRUE(board.isInCheck(board.getPlayerToMove()));
+
+    ASSERT_FALSE(reader.next(game));
+}
+
+TEST(pgn, rejects_invalid_games_and_goes_on)
+{
+    std::string text =
+        "[Event \"1\"]\n\n1. e4 e5 *\n\n"
+        "[Event \"2\"]\n\n1. e4 e5 2. Ke3 *\n\n"
+        "[Event \"3\"]\n\n1. d4 (1. e4 *\n\n"
+        "[Event \"4\"]\n[FEN \"not a position\"]\n\n1. e4 *\n\n"
+        "[Event \"5\"]\n\n1. e4 ) e5 1-0\n\n"
+        "[Event \"6\"]\n\n1. e4 } e5 1-0\n\n";
+    // a NUL byte in the movetext
+    text += std::string("[Event \"7\"]\n\n1. e4 \0 e5 1-0\n\n", 29);
+    text += "[Event \"8\"]\n\n1. d4 d5 2. c4 *\n";
+
+    std::vector<std::string> errors;
+    pgn::Stats stats = pgn::replayAll(text, 1, [&errors](const pgn::Game &game, const std::string &error) {
+        errors.push_back(std::string(game.tag("Event")) + ": " + error);
+    });
+    ASSERT_EQ(stats.m_games, 8u);
+    ASSERT_EQ(stats.m_rejected, 6u);
+    ASSERT_EQ(stats.m_moves, 5u);
+    ASSERT_EQ(errors.size(), 6u);
+    ASSERT_EQ(errors[0], "2: 2. Ke3 is illegal or ambiguous");
+    ASSERT_EQ(errors[1], "3: unterminated variation");
+    ASSERT_EQ(errors[2].substr(0, 15), "4: invalid FEN ");
+    ASSERT_EQ(errors[3], "5: unexpected ')'");
+    ASSERT_EQ(errors[4], "6: unexpected '}'");
+    ASSERT_EQ(errors[5], std::string("7: unexpected '\0'", 17));
+}
+
+TEST(pgn, sharded_replay_matches_one_thread)
+{
+    const std::string text = randomGames(500, 3);
+    ASSERT_GT(text.size(), 4 * 65536u);
+
+    pgn::Stats one = pgn::replayAll(text, 1);
+    pgn::Stats many = pgn::replayAll(text, 4);
+    ASSERT_EQ(one.m_games, 500u);
+    ASSERT_EQ(one.m_rejected, 0u);
+    ASSERT_EQ(many.m_games, one.m_games);
+    ASSERT_EQ(many.m_rejected, 0u);
+    ASSERT_EQ(many.m_moves, one.m_moves);
+
+    // every piece starts on a game
+    for (size_t offset = 0; offset < text.size(); offset += 10007)
+    {
+        size_t start = pgn::nextGame(text, offset);
+        ASSERT_GE(start, offset);
+        ASSERT_TRUE(start == text.size() || text.compare(start, 7, "[Event ") == 0);
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Board.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+// the positions of random games from the perft test positions, which have every kind of move, pin and check
+inline std::vector<Board> randomPositions(size_t count, unsigned seed)
+{
+    const char *fens[] = {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+                          "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+                          "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+                          "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+                          "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+                          "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1"};
+    std::mt19937 rng(seed);
+    std::vector<Board> positions;
+    while (positions.size() < count)
+    {
+        Board board{std::string(fens[positions.size() % 6])};
+        for (int ply = 0; ply < 80 && positions.size() < count; ply++)
+        {
+            positions.push_back(board);
+            MoveList moves;
+            board.getLegalMoves(moves);
+            if (moves.empty())
+                break;
+            board.move(moves[rng() % moves.size()]);
+        }
+    }
+    return positions;
+}
@@ -0,0 +1,123 @@
+#include "gtest/gtest.h"
+#include "Board.h"
+#include "Search.h"
+#include "ThreadedSearch.h"
+
+#include <algorithm>
+#include <random>
+
+TEST(search, finds_back_rank_mate)
+{
+    Board b{std::string("6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1")};
+    search::Search s;
+    search::Limits limits;
+    limits.m_depth = 4;
+    search::Result result = s.run(b, limits);
+
+    ASSERT_EQ(result.m_bestMove.toString(), "a1a8");
+    ASSERT_EQ(result.m_score, search::MATE_SCORE - 1);
+}
+
+TEST(search, takes_hanging_queen)
+{
+    Board b{std::string("4k3/8/8/3q4/8/8/8/3RK3 w - - 0 1")};
+    search::Search s;
+    search::Limits limits;
+    limits.m_depth = 4;
+    search::Result result = s.run(b, limits);
+
+    ASSERT_EQ(result.m_bestMove.toString(), "d1d5");
+    ASSERT_EQ(result.m_depth, 4);
+    ASSERT_FALSE(result.m_pv.empty());
+    ASSERT_TRUE(result.m_pv[0] == result.m_bestMove);
+}
+
+TEST(search, respects_node_budget_and_restores_board)
+{
+    Board b;
+    const uint64_t hash = b.getHash();
+    search::Search s;
+    search::Limits limits;
+    limits.m_nodes = 20000;
+    search::Result result = s.run(b, limits);
+
+    ASSERT_LE(result.m_nodes, 20000);
+    ASSERT_GE(result.m_depth, 1);
+    ASSERT_FALSE(result.m_bestMove.isNull());
+    ASSERT_EQ(b.getHash(), hash);
+    ASSERT_EQ(b.getPlayerToMove(), PlayerColor::White);
+}
+
+TEST(search, no_moves)
+{
+    // stalemate: black king in the corner, no legal moves, not in check
+    Board b{std::string("k7/2Q5/1K6/8/8/8/8/8 b - - 0 1")};
+    search::Search s;
+    search::Result result = s.run(b, search::Limits{});
+    ASSERT_TRUE(result.m_bestMove.isNull());
+    ASSERT_EQ(result.m_score, 0);
+}
+
+TEST(search, lazy_smp_agrees_with_single_thread)
+{
+    Board b{std::string("4k3/8/8/3q4/8/8/8/3RK3 w - - 0 1")};
+    const uint64_t hash = b.getHash();
+    search::ThreadedSearch engine(4, 4);
+    search::Limits limits;
+    limits.m_depth = 6;
+    search::Result result = engine.run(b, limits);
+
+    ASSERT_EQ(engine.threads(), 4);
+    ASSERT_EQ(result.m_bestMove.toString(), "d1d5");
+    ASSERT_EQ(result.m_depth, 6);
+    ASSERT_EQ(b.getHash(), hash);
+
+    // fewer threads reuses the table and the remaining searches
+    engine.setThreads(1);
+    ASSERT_EQ(engine.run(b, limits).m_bestMove.toString(), "d1d5");
+}
+
+TEST(search, quiescence_sees_recaptures)
+{
+    // at depth 1 the queen taking the pawn looks like a pawn won, unless the recapture is searched
+    Board b{std::string("4k3/8/3p4/4p3/8/8/8/4QK2 w - - 0 1")};
+    search::Search s;
+    search::Limits limits;
+    limits.m_depth = 1;
+    search::Result result = s.run(b, limits);
+
+    ASSERT_NE(result.m_bestMove.toString(), "e1e5");
+}
+
+TEST(search, move_picker_yields_every_move_once)
+{
+    std::mt19937 generator(585);
+    search::History history;
+    history.clear();
+    Board b{std::string("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1")};
+    for (int played = 0; played < 40; played++)
+    {
+        MoveList moves;
+        b.getLegalMoves(moves);
+        if (moves.empty())
+            break;
+
+        // a legal hash move, a killer that may not be legal here, and one that's certainly not
+        Move hashMove = moves[generator() % moves.size()];
+        Move killers[2] = {moves[generator() % moves.size()], Move(SQUARE(4, 4), SQUARE(0, 0))};
+        ASSERT_TRUE(b.isLegal(hashMove));
+        ASSERT_FALSE(b.isLegal(killers[1]));
+        history.update(b.getPlayerToMove(), moves[generator() % moves.size()], 100);
+
+        search::MovePicker picker(b, hashMove, killers, history);
+        std::vector<Move> picked;
+        for (Move move = picker.next(); !move.isNull(); move = picker.next())
+            picked.push_back(move);
+
+        ASSERT_EQ(picked.size(), moves.size()) << b.getFen();
+        ASSERT_TRUE(picked[0] == hashMove);
+        for (const Move &move : moves)
+            ASSERT_EQ(std::count(picked.begin(), picked.end(), move), 1) << move.toString();
+        b.move(moves[generator() % moves.size()]);
+    }
+}
@@ -0,0 +1,93 @@
+#include "gtest/gtest.h"
+#include "Batch.h"
+#include "Board.h"
+#include "TrainingData.h"
+#include "positions.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+static std::vector<training::PackedPosition> randomRecords(size_t count, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::vector<training::PackedPosition> records;
+    for (const Board &board : randomPositions(count, seed))
+        records.push_back(training::pack(board, static_cast<int>(rng() % 2001) - 1000, static_cast<int>(rng() % 3) - 1));
+    return records;
+}
+
+TEST(training, pack_round_trip)
+{
+    for (const Board &board : randomPositions(480, 11))
+    {
+        // scores come in for the side to move and are kept for white
+        training::PackedPosition packed = training::pack(board, 35, -1);
+        ASSERT_EQ(packed.m_score, board.getPlayerToMove() == PlayerColor::White ? 35 : -35);
+        ASSERT_EQ(packed.m_result, -1);
+        ASSERT_EQ(training::toFen(packed), board.getFen());
+        Board unpacked;
+        ASSERT_TRUE(training::unpack(packed, unpacked));
+        ASSERT_EQ(unpacked.getHash(), board.getHash());
+
+        // and straight into a batch, with the same moves
+        batch::Positions positions;
+        positions.resize(2);
+        positions.set(0, board);
+        positions.set(1, packed);
+        batch::MoveLists lists;
+        batch::generateLegalMoves(positions, lists);
+        ASSERT_TRUE(std::equal(lists.begin(0), lists.end(0), lists.begin(1), lists.end(1)));
+    }
+}
+
+TEST(training, files_append_and_shuffle)
+{
+    const char *path = "training_test.bin";
+    const char *shuffled = "training_test_shuffled.bin";
+    std::remove(path);
+    std::vector<training::PackedPosition> records = randomRecords(1000, 3);
+    {
+        // two writers one after the other append, the way concatenated files would be
+        training::Writer writer;
+        ASSERT_TRUE(writer.open(path));
+        writer.write(records.data(), 600);
+    }
+    {
+        training::Writer writer;
+        ASSERT_TRUE(writer.open(path));
+        writer.write(records.data() + 600, 400);
+    }
+
+    auto key = [](const training::PackedPosition &position) {
+        return std::string(reinterpret_cast<const char *>(&position), sizeof(position));
+    };
+    training::Reader reader;
+    ASSERT_TRUE(reader.open(path));
+    ASSERT_EQ(reader.size(), records.size());
+    for (size_t i = 0; i < records.size(); i++)
+        ASSERT_EQ(key(reader[i]), key(records[i]));
+
+    // the same records in another order
+    ASSERT_TRUE(training::shuffle(path, shuffled, 7));
+    training::Reader shuffledReader;
+    ASSERT_TRUE(shuffledReader.open(shuffled));
+    ASSERT_EQ(shuffledReader.size(), records.size());
+    std::vector<std::string> before, after;
+    bool moved = false;
+    for (size_t i = 0; i < records.size(); i++)
+    {
+        before.push_back(key(records[i]));
+        after.push_back(key(shuffledReader[i]));
+        moved |= before.back() != after.back();
+    }
+    ASSERT_TRUE(moved);
+    std::sort(before.begin(), before.end());
+    std::sort(after.begin(), after.end());
+    ASSERT_EQ(before, after);
+
+    std::remove(path);
+    std::remove(shuffled);
+}
@@ -0,0 +1,76 @@
+#include "gtest/gtest.h"
+#include "Board.h"
+#include "Search.h"
+#include "TranspositionTable.h"
+
+TEST(transposition, store_and_probe)
+{
+    search::TranspositionTable table(1);
+    Board b;
+    MoveList moves;
+    b.getLegalMoves(moves);
+    Move move = moves[3];
+
+    search::TTEntry entry;
+    ASSERT_FALSE(table.probe(b.getHash(), entry));
+    table.store(b.getHash(), move, -42, 7, search::BOUND_LOWER);
+    ASSERT_TRUE(table.probe(b.getHash(), entry));
+    ASSERT_TRUE(entry.m_move == move);
+    ASSERT_EQ(entry.m_score, -42);
+    ASSERT_EQ(entry.m_depth, 7);
+    ASSERT_EQ(entry.m_bound, search::BOUND_LOWER);
+    // same bucket, different position
+    ASSERT_FALSE(table.probe(b.getHash() ^ (uint64_t{1} << 63), entry));
+
+    table.clear();
+    ASSERT_FALSE(table.probe(b.getHash(), entry));
+}
+
+TEST(transposition, keeps_deep_entries)
+{
+    search::TranspositionTable table(1);
+    // six positions that all land in the same bucket: the shallowest are the ones pushed out
+    const uint64_t stride = uint64_t{1} << 40;
+    for (int i = 0; i < 6; i++)
+        table.store(1 + i * stride, Move(), 0, i == 0 ? 20 : i, search::BOUND_EXACT);
+
+    search::TTEntry entry;
+    ASSERT_TRUE(table.probe(1, entry));
+    ASSERT_EQ(entry.m_depth, 20);
+    ASSERT_FALSE(table.probe(1 + 1 * stride, entry));
+    ASSERT_TRUE(table.probe(1 + 5 * stride, entry));
+
+    // once a few searches have gone by, even a deep entry is fair game
+    for (int i = 0; i < 4; i++)
+        table.newSearch();
+    for (int i = 6; i < 10; i++)
+        table.store(1 + i * stride, Move(), 0, 1, search::BOUND_EXACT);
+    ASSERT_FALSE(table.probe(1, entry));
+}
+
+TEST(transposition, mate_scores_relative_to_ply)
+{
+    int mateIn3 = search::MATE_SCORE - 5;
+    ASSERT_EQ(search::scoreFromTable(search::scoreToTable(mateIn3, 2), 2), mateIn3);
+    // found 2 plies from the root, it's a mate 2 plies sooner when reached straight from the root
+    ASSERT_EQ(search::scoreFromTable(search::scoreToTable(mateIn3, 2), 0), mateIn3 + 2);
+    ASSERT_EQ(search::scoreToTable(-mateIn3, 2), -mateIn3 - 2);
+    ASSERT_EQ(search::scoreToTable(150, 10), 150);
+}
+
+TEST(transposition, shared_table_speeds_up_research)
+{
+    search::TranspositionTable table(4);
+    search::Limits limits;
+    limits.m_depth = 6;
+
+    Board b{std::string("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1")};
+    search::Search first(table);
+    search::Result cold = first.run(b, limits);
+    search::Search second(table);
+    search::Result warm = second.run(b, limits);
+
+    ASSERT_EQ(warm.m_depth, 6);
+    ASSERT_LT(warm.m_nodes, cold.m_nodes);
+    ASSERT_TRUE(warm.m_bestMove == cold.m_bestMove);
+}
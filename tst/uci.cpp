@@ -0,0 +1,79 @@
+#include "gtest/gtest.h"
+#include "Search.h"
+#include "Uci.h"
+
+#include <sstream>
+#include <string>
+#include <thread>
+
+TEST(uci, handshake)
+{
+    std::ostringstream out;
+    uci::Engine engine(out);
+    ASSERT_TRUE(engine.handle("uci"));
+    ASSERT_TRUE(engine.handle("setoption name Hash value 1"));
+    ASSERT_TRUE(engine.handle("isready"));
+    ASSERT_FALSE(engine.handle("quit"));
+
+    const std::string replies = out.str();
+    ASSERT_NE(replies.find("option name Hash type spin"), std::string::npos);
+    ASSERT_NE(replies.find("option name Threads type spin"), std::string::npos);
+    ASSERT_NE(replies.find("uciok"), std::string::npos);
+    ASSERT_NE(replies.find("readyok"), std::string::npos);
+    ASSERT_EQ(replies.find("Unknown"), std::string::npos);
+}
+
+TEST(uci, position_and_go_depth)
+{
+    std::ostringstream out;
+    uci::Engine engine(out);
+    // after 1. f3 e5 2. g4 black mates
+    engine.handle("position startpos moves f2f3 e7e5 g2g4");
+    engine.handle("go depth 3");
+    engine.waitForSearch();
+
+    const std::string replies = out.str();
+    ASSERT_NE(replies.find("info depth 1 "), std::string::npos);
+    ASSERT_NE(replies.find("score mate 1"), std::string::npos);
+    ASSERT_NE(replies.find("bestmove d8h4"), std::string::npos);
+}
+
+TEST(uci, infinite_waits_for_stop)
+{
+    std::ostringstream out;
+    uci::Engine engine(out);
+    engine.handle("position fen 6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1");
+    engine.handle("go infinite");
+    engine.handle("isready");
+    // the mate is found at once and the search ends, but the move is only reported after stop
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    ASSERT_NE(out.str().find("readyok"), std::string::npos);
+    ASSERT_EQ(out.str().find("bestmove"), std::string::npos);
+
+    engine.handle("stop");
+    ASSERT_NE(out.str().find("bestmove a1a8"), std::string::npos);
+}
+
+TEST(uci, no_legal_moves)
+{
+    std::ostringstream out;
+    uci::Engine engine(out);
+    engine.handle("position fen 7k/5QQ1/8/8/8/8/8/K7 b - - 0 1");
+    engine.handle("go depth 2");
+    engine.waitForSearch();
+    ASSERT_NE(out.str().find("bestmove 0000"), std::string::npos);
+}
+
+TEST(uci, clock_limits)
+{
+    // sudden death: a small share of what's left, with the hard limit above the soft one
+    search::Limits limits = search::clockLimits(60000, 0, 0);
+    ASSERT_GT(limits.m_softTimeMs, 0);
+    ASSERT_LT(limits.m_softTimeMs, 5000);
+    ASSERT_GT(limits.m_timeMs, limits.m_softTimeMs);
+
+    // never more than what's on the clock, even when it's nearly gone
+    limits = search::clockLimits(50, 1000, 1);
+    ASSERT_GE(limits.m_timeMs, 1);
+    ASSERT_LT(limits.m_timeMs, 50);
+}
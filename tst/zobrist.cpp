@@ -0,0 +1,67 @@
+#include "gtest/gtest.h"
+#include "Board.h"
+
+#include <random>
+
+TEST(zobrist, incremental_matches_recompute)
+{
+    // random games from a position with castling, en passant and promotions close by
+    std::mt19937 generator(585);
+    for (int game = 0; game < 20; game++)
+    {
+        Board b{std::string("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1")};
+        const uint64_t start = b.getHash();
+        int played = 0;
+        for (; played < 60; played++)
+        {
+            MoveList moves;
+            b.getLegalMoves(moves);
+            if (moves.empty())
+                break;
+            b.move(moves[generator() % moves.size()]);
+            ASSERT_EQ(b.getHash(), b.computeHash());
+            ASSERT_EQ(b.getPawnHash(), b.computePawnHash());
+        }
+        for (; played > 0; played--)
+        {
+            b.undo();
+            ASSERT_EQ(b.getHash(), b.computeHash());
+            ASSERT_EQ(b.getPawnHash(), b.computePawnHash());
+        }
+        ASSERT_EQ(b.getHash(), start);
+    }
+}
+
+TEST(zobrist, transpositions_hash_the_same)
+{
+    Board knights;
+    Board start;
+    // Nf3 Nf6 Ng1 Ng8 gets back to the start position
+    knights.move(Move(SQUARE(7, 6), SQUARE(5, 5)));
+    knights.move(Move(SQUARE(0, 6), SQUARE(2, 5)));
+    ASSERT_NE(knights.getHash(), start.getHash());
+    knights.move(Move(SQUARE(5, 5), SQUARE(7, 6)));
+    knights.move(Move(SQUARE(2, 5), SQUARE(0, 6)));
+    ASSERT_EQ(knights.getHash(), start.getHash());
+
+    // the same pieces but white to move vs black to move
+    Board white{std::string("4k3/8/8/8/8/8/8/4K3 w - - 0 1")};
+    Board black{std::string("4k3/8/8/8/8/8/8/4K3 b - - 0 1")};
+    ASSERT_NE(white.getHash(), black.getHash());
+}
+
+TEST(zobrist, castling_rights_are_hashed)
+{
+    // the king walks away and back: same squares, but the rights are gone
+    Board b{std::string("r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1")};
+    Board noRights{std::string("r3k2r/8/8/8/8/8/8/R3K2R w kq - 0 1")};
+    b.move(Move(SQUARE(7, 4), SQUARE(7, 5)));
+    b.move(Move(SQUARE(0, 0), SQUARE(0, 1)));
+    b.move(Move(SQUARE(7, 5), SQUARE(7, 4)));
+    b.move(Move(SQUARE(0, 1), SQUARE(0, 0)));
+    ASSERT_EQ(b.getCastlingRights(), CastlingRights::BLACK_KINGSIDE);
+    ASSERT_NE(b.getHash(), noRights.getHash());
+
+    Board kingsideOnly{std::string("r3k2r/8/8/8/8/8/8/R3K2R w k - 0 1")};
+    ASSERT_EQ(b.getHash(), kingsideOnly.getHash());
+}
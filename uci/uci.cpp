@@ -0,0 +1,13 @@
+// # Copyright (c) Dylan Leclair
+
+#include "Uci.h"
+
+#include <iostream>
+
+// speaks UCI on stdin/stdout, for playing in a GUI or against other engines
+int main()
+{
+    uci::Engine engine(std::cout);
+    engine.loop(std::cin);
+    return 0;
+}